@@ -10,42 +10,31 @@
  * Copyright (C) 2024  Jeff Jackowski
  */
 #include "Attention.hpp"
+#include "Metrics.hpp"
+#include "PpsInput.hpp"
+#include "Trace.hpp"
 #include <duds/time/planetary/Planetary.hpp>
-#include <system_error>
 #include <iostream>
-#include <csignal>
+#include <algorithm>
+#include <cmath>
 #include <boost/exception/diagnostic_information.hpp>
 
-extern std::atomic_bool quit;
-
 Attention::Record::Record(int t, int pri, int p, Audible aud) :
 time(t), priority(pri), page(p), sound(aud) { }
 
 Attention::Attention(
+	duds::os::linux::Poller &p,
 	const duds::hardware::devices::clocks::LinuxClockSptr &lcs,
-	const duds::hardware::interface::DigitalPin &buz
-) : clock(lcs) {
+	const duds::hardware::interface::DigitalPin &buz,
+	const PpsInput *pp
+) : clock(lcs), pps(pp), timer(p, std::bind(&Attention::expired, this)) {
 	setBuzzer(buz);
-	running = std::thread(&Attention::run, this);
 }
 
 Attention::~Attention() {
-	{
-		std::lock_guard<std::mutex> lock(block);
-		records.clear();
-		page = 42;
-	}
-	change.notify_one();
-	try {
-		running.join();
-	} catch (const std::system_error& e) {
-		// invalid_argument may occur if thread has terminated
-		/*
-		if (e.code() != std::errc::invalid_argument) {
-			// something else
-			throw;
-		}
-		*/
+	// do not leave the buzzer on
+	if (step) {
+		output(false);
 	}
 }
 
@@ -68,146 +57,173 @@ void Attention::setBuzzer(const duds::hardware::interface::DigitalPin &buz) {
 	}
 }
 
-// in milliseconds
+// in milliseconds; time before the event that the sound starts
 static int buzlen[Attention::Total] = {
 	0,
 	450,
-	3100,
+	3000,
 	400
 };
 
-void Attention::run()
-try {
-	// start by waiting
-	std::unique_lock<std::mutex> lock(block);
-	while (records.empty() && (page != 42)) {
-		change.wait(lock);
+static const Attention::Step noSoundSteps[] = {
+	{ -1, false }
+};
+
+static const Attention::Step noticeSteps[] = {
+	{ 0, true },
+	{ 150, false },
+	{ 300, true },
+	{ 450, false },
+	{ -1, false }
+};
+
+// three beeps on the seconds before the time, and a long tone starting on
+// the time
+static const Attention::Step timeSteps[] = {
+	{ 0, true },
+	{ 200, false },
+	{ 1000, true },
+	{ 1200, false },
+	{ 2000, true },
+	{ 2200, false },
+	{ 3000, true },
+	{ 4000, false },
+	{ -1, false }
+};
+
+static const Attention::Step warningSteps[] = {
+	{ 0, true },
+	{ 400, false },
+	{ -1, false }
+};
+
+const Attention::Step *Attention::sounds[Attention::Total] = {
+	noSoundSteps,
+	noticeSteps,
+	timeSteps,
+	warningSteps
+};
+
+void Attention::output(bool on) {
+	try {
+		duds::hardware::interface::DigitalPinAccess buz;
+		buzzer.access(&buz);
+		buz.output(on);
+	} catch (...) {
+		std::cerr << "Attention error during buzzer output:\n" <<
+		boost::current_exception_diagnostic_information()
+		<< std::endl;
 	}
-	if (page == 42) {
+}
+
+void Attention::schedule() {
+	if (step) {
+		// the next item is scheduled after the sound ends
 		return;
 	}
 	duds::hardware::devices::clocks::LinuxClock::Measurement::TimeSample ts;
-	boost::posix_time::time_duration time;
-	// begin operating loop
-	do {
-		// get the current time
-		clock->sampleTime(ts);
-		// find seconds since midnight UTC
-		time = duds::time::planetary::earth->posix(ts.value).time_of_day();
-		if (testTimeOffset) {
-			time += boost::posix_time::seconds(testTimeOffset);
-		}
-		// find next item time-wise
-		RecordContainer::index<index_time>::type &timeIdx =
-			records.get<index_time>();
-		RecordContainer::index<index_time>::type::iterator iter = timeIdx.begin();
-		// it may be well in the past
-		while ((iter != timeIdx.end()) && (iter->time - time.total_seconds()) < 0) {
-			iter = timeIdx.erase(iter);			
-		}
-		// that may have eliminated everything
-		if (iter == timeIdx.end()) {
-			// wait until something happens
-			change.wait(lock);
-		} else {
-			// find highest priority item; there may be a better way
-			RecordContainer::index<index_time>::type::iterator next = iter;
-			for (++next; (next != timeIdx.end()) && (next->time == iter->time); ++next) {
-				if (next->priority < iter->priority) {
-					iter = next;
-				}
-			}
-			// work out time to wait
-			std::chrono::milliseconds delay(
-				iter->time * 1000 - time.total_milliseconds() - buzlen[iter->sound]
-			);
-			// time to make noise?
-			if (delay.count() < 16) {
-				page = iter->page;
-				int snd = iter->sound;
-				// remove all records for this time
-				auto range = timeIdx.equal_range(iter->time);
-				timeIdx.erase(range.first, range.second);
-				// after unlocking, member variables must not be used
-				lock.unlock();
-				if (buzzer.havePin()) {
-					try {
-						duds::hardware::interface::DigitalPinAccess buz;
-						buzzer.access(&buz);
-						switch (snd) {
-							case NoSound:
-								break;
-							case Notice:
-								buz.output(true);
-								std::this_thread::sleep_for(std::chrono::milliseconds(150));
-								buz.output(false);
-								std::this_thread::sleep_for(std::chrono::milliseconds(150));
-								buz.output(true);
-								std::this_thread::sleep_for(std::chrono::milliseconds(150));
-								buz.output(false);
-								break;
-							case Time:
-								// one beep
-								buz.output(true);
-								std::this_thread::sleep_for(std::chrono::milliseconds(200));
-								buz.output(false);
-								std::this_thread::sleep_for(std::chrono::milliseconds(800));
-								// two beeps
-								buz.output(true);
-								std::this_thread::sleep_for(std::chrono::milliseconds(200));
-								buz.output(false);
-								std::this_thread::sleep_for(std::chrono::milliseconds(800));
-								// three beeps
-								buz.output(true);
-								std::this_thread::sleep_for(std::chrono::milliseconds(200));
-								buz.output(false);
-								std::this_thread::sleep_for(std::chrono::milliseconds(800));
-								// long tone
-								buz.output(true);
-								std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-								buz.output(false);
-								break;
-							case Warning:
-								buz.output(true);
-								std::this_thread::sleep_for(std::chrono::milliseconds(400));
-								buz.output(false);
-						}
-					} catch (...) {
-						std::cerr << "Attention thread error during buzzer output:\n" <<
-						boost::current_exception_diagnostic_information()
-						<< std::endl;
-					}
-				}
-				lock.lock();
-			} else {
-				// wait
-				change.wait_for(lock, delay);
-			}
+	// get the current time
+	clock->sampleTime(ts);
+	// correct to the true second if measured
+	double ppsOff;
+	if (pps && pps->offset(ppsOff)) {
+		ts.value -= duds::time::interstellar::Nanoseconds(
+			std::llround(ppsOff * 1e9)
+		);
+	}
+	// find seconds since midnight UTC
+	boost::posix_time::time_duration time =
+		duds::time::planetary::earth->posix(ts.value).time_of_day();
+	if (testTimeOffset) {
+		time += boost::posix_time::seconds(testTimeOffset);
+	}
+	// find next item time-wise
+	RecordContainer::index<index_time>::type &timeIdx =
+		records.get<index_time>();
+	RecordContainer::index<index_time>::type::iterator iter = timeIdx.begin();
+	// it may be well in the past
+	while ((iter != timeIdx.end()) && (iter->time - time.total_seconds()) < 0) {
+		iter = timeIdx.erase(iter);
+	}
+	// that may have eliminated everything
+	if (iter == timeIdx.end()) {
+		// wait until something is added
+		timer.disarm();
+		return;
+	}
+	// find highest priority item; there may be a better way
+	RecordContainer::index<index_time>::type::iterator next = iter;
+	for (++next; (next != timeIdx.end()) && (next->time == iter->time); ++next) {
+		if (next->priority < iter->priority) {
+			iter = next;
 		}
-	} while ((page != 42) && !quit);
-} catch (...) {
-	std::cerr << "Program failed in attention thread:\n" <<
-	boost::current_exception_diagnostic_information()
-	<< std::endl;
+	}
+	// work out time to wait
+	std::chrono::microseconds delay(
+		(iter->time * 1000LL - buzlen[iter->sound]) * 1000LL -
+		time.total_microseconds()
+	);
+	// not time to make noise yet?
+	if (delay > std::chrono::milliseconds(1)) {
+		timer.once(delay);
+		return;
+	}
+	page = iter->page;
+	int snd = iter->sound;
+	// remove all records for this time
+	auto range = timeIdx.equal_range(iter->time);
+	timeIdx.erase(range.first, range.second);
+	// a sound without any steps, like NoSound, needs no sequence
+	if (buzzer.havePin() && (sounds[snd]->time >= 0)) {
+		// each part of the sound is timed from the start so that delays do
+		// not accumulate
+		soundStart = std::chrono::steady_clock::now() +
+			std::max(delay, std::chrono::microseconds(0));
+		step = sounds[snd];
+		timer.once(soundStart - std::chrono::steady_clock::now());
+	} else {
+		schedule();
+	}
+}
+
+void Attention::expired() {
+	TRACE_SPAN("Attention::expired");
+	if (!step) {
+		schedule();
+		return;
+	}
+	// lateness of the change from when it should have happened
+	metrics.alarmLateness.observe(
+		std::chrono::steady_clock::now() - soundStart -
+		std::chrono::milliseconds(step->time)
+	);
+	output(step->on);
+	if ((++step)->time < 0) {
+		// sound is over
+		step = nullptr;
+		schedule();
+	} else {
+		timer.once(
+			soundStart + std::chrono::milliseconds(step->time) -
+			std::chrono::steady_clock::now()
+		);
+	}
 }
 
 void Attention::add(int time, int priority, int page, Audible sound) {
-	std::lock_guard<std::mutex> lock(block);
 	records.emplace(time, priority, page, sound);
-	change.notify_one();
+	schedule();
 }
 
 void Attention::remove(int page) {
-	std::lock_guard<std::mutex> lock(block);
 	RecordContainer::index<index_page>::type &pageIdx = records.get<index_page>();
 	//std::pair<RecordContainer::index<index_page>::type::iterator
 	auto range = pageIdx.equal_range(page);
 	pageIdx.erase(range.first, range.second);
-	change.notify_one();
+	schedule();
 }
 
 int Attention::changeToPage() {
-	std::lock_guard<std::mutex> lock(block);
 	int ret = page;
 	// reset attention page
 	page = -1;
@@ -18,8 +18,15 @@
 #include <boost/multi_index/tag.hpp>
 #include <duds/hardware/interface/DigitalPin.hpp>
 #include <duds/hardware/devices/clocks/LinuxClock.hpp>
-#include <thread>
+#include "TimerFd.hpp"
 
+class PpsInput;
+
+/**
+ * Sounds the buzzer and requests page changes at scheduled times. Runs on
+ * the thread that handles the Poller; a timer wakes it for each scheduled
+ * item, and for each change of the buzzer while a sound plays.
+ */
 class Attention {
 public:
 	enum Audible {
@@ -29,6 +36,16 @@ public:
 		Warning,
 		Total
 	};
+	/**
+	 * One change of the buzzer output during a sound.
+	 */
+	struct Step {
+		/**
+		 * Milliseconds from the start of the sound, or -1 to end the sound.
+		 */
+		int time;
+		bool on;
+	};
 private:
 	struct Record {
 		int time;
@@ -55,19 +72,53 @@ private:
 			>
 		>
 	> RecordContainer;
+	static const Step *sounds[Total];
 	RecordContainer records;
 	duds::hardware::interface::DigitalPin buzzer;
 	duds::hardware::devices::clocks::LinuxClockSptr clock;
-	std::thread running;
-	std::mutex block;
-	std::condition_variable change;
+	/**
+	 * Optional measure of the system clock's error; used to sound alarms on
+	 * the true second.
+	 */
+	const PpsInput *pps;
+	TimerFd timer;
+	/**
+	 * When the sound being played started.
+	 */
+	std::chrono::steady_clock::time_point soundStart;
+	/**
+	 * The next step of the sound being played, or nullptr when silent.
+	 */
+	const Step *step = nullptr;
 	int page = -1;
 	int testTimeOffset = 0;
-	void run();
+	/**
+	 * Removes past items and arms the timer for the next item, or starts
+	 * its sound if it is due. Does nothing while a sound is playing.
+	 */
+	void schedule();
+	/**
+	 * Handles the timer.
+	 */
+	void expired();
+	/**
+	 * Sets the buzzer output.
+	 */
+	void output(bool on);
 public:
+	/**
+	 * Prepares to sound alarms.
+	 * @param p    The Poller that will handle the timer.
+	 * @param lcs  The clock used for the time.
+	 * @param buz  The buzzer output.
+	 * @param pp   The PPS input used to correct the clock, or nullptr. It
+	 *             must outlive this object.
+	 */
 	Attention(
+		duds::os::linux::Poller &p,
 		const duds::hardware::devices::clocks::LinuxClockSptr &lcs,
-		const duds::hardware::interface::DigitalPin &buz
+		const duds::hardware::interface::DigitalPin &buz,
+		const PpsInput *pp = nullptr
 	);
 	~Attention();
 	void setBuzzer(const duds::hardware::interface::DigitalPin &buz);
@@ -79,7 +130,7 @@ public:
 	 */
 	void timeOffset(int toff) {
 		testTimeOffset = toff;
-		change.notify_one();
+		schedule();
 	}
 };
 
@@ -0,0 +1,235 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "Besselian.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Earth's flattening related constants
+static constexpr double polarRatio = 0.99664719;   // b/a
+static constexpr double eSquared = 0.00669438;     // eccentricity squared
+static constexpr double equatorRadius = 6378137.0; // in meters
+// converts delta T in seconds to degrees of rotation
+static constexpr double deltaTDeg = 0.00417807;
+static constexpr double degToRad = M_PI / 180.0;
+
+struct Besselian::Terms {
+	double u, v;   // location relative to shadow axis
+	double a, b;   // hourly rate of change of u and v
+	double n2, n;  // squared and plain speed of u,v
+	double L1, L2; // penumbral and umbral radii at the location
+	double zeta;   // positive when the sun is above the horizon
+};
+
+void Besselian::terms(
+	Terms &tm,
+	double rhoSin,
+	double rhoCos,
+	double lon,
+	double t
+) const {
+	double x = be.x[0] + t * (be.x[1] + t * (be.x[2] + t * be.x[3]));
+	double xp = be.x[1] + t * (2.0 * be.x[2] + t * 3.0 * be.x[3]);
+	double y = be.y[0] + t * (be.y[1] + t * (be.y[2] + t * be.y[3]));
+	double yp = be.y[1] + t * (2.0 * be.y[2] + t * 3.0 * be.y[3]);
+	double d = (be.d[0] + t * (be.d[1] + t * be.d[2])) * degToRad;
+	double dp = (be.d[1] + t * 2.0 * be.d[2]) * degToRad;
+	double mup = (be.mu[1] + t * 2.0 * be.mu[2]) * degToRad;
+	// hour angle of the shadow axis at the location
+	double H = (be.mu[0] + t * (be.mu[1] + t * be.mu[2]) + lon -
+		deltaTDeg * be.deltaT) * degToRad;
+	double sinH = std::sin(H), cosH = std::cos(H);
+	double sind = std::sin(d), cosd = std::cos(d);
+	// location on the fundamental plane
+	double xi = rhoCos * sinH;
+	double eta = rhoSin * cosd - rhoCos * cosH * sind;
+	tm.zeta = rhoSin * sind + rhoCos * cosH * cosd;
+	double xip = mup * rhoCos * cosH;
+	double etap = mup * xi * sind - tm.zeta * dp;
+	tm.u = x - xi;
+	tm.v = y - eta;
+	tm.a = xp - xip;
+	tm.b = yp - etap;
+	tm.n2 = tm.a * tm.a + tm.b * tm.b;
+	tm.n = std::sqrt(tm.n2);
+	tm.L1 = be.l1[0] + t * (be.l1[1] + t * be.l1[2]) - tm.zeta * be.tanf1;
+	tm.L2 = be.l2[0] + t * (be.l2[1] + t * be.l2[2]) - tm.zeta * be.tanf2;
+}
+
+/**
+ * Computes the geocentric terms for an observer.
+ */
+static void observer(
+	double &rhoSin,
+	double &rhoCos,
+	const Location &loc,
+	double elev
+) {
+	double lat = loc.lat * degToRad;
+	double U = std::atan(polarRatio * std::tan(lat));
+	rhoSin = polarRatio * std::sin(U) + elev / equatorRadius * std::sin(lat);
+	rhoCos = std::cos(U) + elev / equatorRadius * std::cos(lat);
+}
+
+double Besselian::contact(
+	double rhoSin,
+	double rhoCos,
+	double lon,
+	double t,
+	bool umbral,
+	double sign
+) const {
+	Terms tm;
+	// converges in two or three steps
+	for (int i = 0; i < 8; ++i) {
+		terms(tm, rhoSin, rhoCos, lon, t);
+		double L = umbral ? tm.L2 : tm.L1;
+		double delta = (tm.a * tm.v - tm.u * tm.b) / tm.n;
+		double r = L * L - delta * delta;
+		double tau = -(tm.u * tm.a + tm.v * tm.b) / tm.n2 +
+			sign * std::sqrt(std::max(r, 0.0)) / tm.n;
+		t += tau;
+		// about a millisecond
+		if (std::fabs(tau) < 3e-7) {
+			break;
+		}
+	}
+	return t;
+}
+
+bool Besselian::local(
+	LocalCircumstances &lc,
+	const Location &loc,
+	double elev
+) const {
+	double rhoSin, rhoCos;
+	observer(rhoSin, rhoCos, loc, elev);
+	// find the time of maximum eclipse
+	Terms tm;
+	double t = 0;
+	for (int i = 0; i < 8; ++i) {
+		terms(tm, rhoSin, rhoCos, loc.lon, t);
+		double tau = -(tm.u * tm.a + tm.v * tm.b) / tm.n2;
+		t += tau;
+		if (std::fabs(tau) < 3e-7) {
+			break;
+		}
+	}
+	terms(tm, rhoSin, rhoCos, loc.lon, t);
+	double m = std::sqrt(tm.u * tm.u + tm.v * tm.v);
+	lc.max = utcSeconds(t);
+	lc.umbraDistance = m - std::fabs(tm.L2);
+	lc.partial = (m < tm.L1) && (tm.zeta > 0);
+	if (!lc.partial) {
+		lc.magnitude = lc.obscuration = 0;
+		lc.total = false;
+		lc.c1 = lc.c2 = lc.c3 = lc.c4 = lc.max;
+		return false;
+	}
+	lc.magnitude = (tm.L1 - m) / (tm.L1 + tm.L2);
+	lc.obscuration = obscuration(
+		2.0 * m / (tm.L1 + tm.L2),
+		(tm.L1 - tm.L2) / (tm.L1 + tm.L2)
+	);
+	lc.c1 = utcSeconds(contact(rhoSin, rhoCos, loc.lon, t, false, -1.0));
+	lc.c4 = utcSeconds(contact(rhoSin, rhoCos, loc.lon, t, false, 1.0));
+	// L2 is negative for a total eclipse
+	lc.total = (tm.L2 < 0) && (m < -tm.L2);
+	if (lc.total) {
+		lc.c2 = utcSeconds(contact(rhoSin, rhoCos, loc.lon, t, true, -1.0));
+		lc.c3 = utcSeconds(contact(rhoSin, rhoCos, loc.lon, t, true, 1.0));
+	} else {
+		lc.c2 = lc.c3 = lc.max;
+	}
+	return true;
+}
+
+void Besselian::coverage(
+	double &mag,
+	double &obs,
+	const Location &loc,
+	double time
+) const {
+	double rhoSin, rhoCos;
+	observer(rhoSin, rhoCos, loc, 0);
+	Terms tm;
+	terms(tm, rhoSin, rhoCos, loc.lon, hours(time));
+	double m = std::sqrt(tm.u * tm.u + tm.v * tm.v);
+	if ((m >= tm.L1) || (tm.zeta <= 0)) {
+		mag = obs = 0;
+	} else {
+		mag = (tm.L1 - m) / (tm.L1 + tm.L2);
+		obs = obscuration(
+			2.0 * m / (tm.L1 + tm.L2),
+			(tm.L1 - tm.L2) / (tm.L1 + tm.L2)
+		);
+	}
+}
+
+void Besselian::shadow(ShadowPosition &sp, double time) const {
+	double t = hours(time);
+	double x = be.x[0] + t * (be.x[1] + t * (be.x[2] + t * be.x[3]));
+	double y = be.y[0] + t * (be.y[1] + t * (be.y[2] + t * be.y[3]));
+	double d = (be.d[0] + t * (be.d[1] + t * be.d[2])) * degToRad;
+	double mu = be.mu[0] + t * (be.mu[1] + t * be.mu[2]);
+	// account for the Earth's flattening
+	double rho1 = std::sqrt(1.0 - eSquared * std::cos(d) * std::cos(d));
+	double sind1 = std::sin(d) / rho1;
+	double cosd1 = std::sqrt(1.0 - eSquared) * std::cos(d) / rho1;
+	double y1 = y / rho1;
+	double B = 1.0 - x * x - y1 * y1;
+	if (B < 0) {
+		// shadow axis misses the Earth
+		sp.onEarth = false;
+		return;
+	}
+	double zeta1 = std::sqrt(B);
+	double sinphi1 = y1 * cosd1 + zeta1 * sind1;
+	double theta = std::atan2(x, zeta1 * cosd1 - y1 * sind1) / degToRad;
+	double phi1 = std::asin(sinphi1);
+	sp.center.lat = std::atan2(
+		std::sin(phi1),
+		std::sqrt(1.0 - eSquared) * std::cos(phi1)
+	) / degToRad;
+	sp.center.lon = std::remainder(
+		theta - mu + deltaTDeg * be.deltaT,
+		360.0
+	);
+	double zeta = rho1 * zeta1;
+	sp.umbraRadius = std::fabs(
+		be.l2[0] + t * (be.l2[1] + t * be.l2[2]) - zeta * be.tanf2
+	) * equatorRadius / 1000.0;
+	sp.penumbraRadius = (
+		be.l1[0] + t * (be.l1[1] + t * be.l1[2]) - zeta * be.tanf1
+	) * equatorRadius / 1000.0;
+	sp.onEarth = true;
+}
+
+double Besselian::obscuration(double sep, double ratio) {
+	// no overlap?
+	if (sep >= (1.0 + ratio)) {
+		return 0;
+	}
+	// one disk entirely inside the other?
+	if (sep <= std::fabs(1.0 - ratio)) {
+		return std::min(ratio * ratio, 1.0);
+	}
+	// area of the lens formed by the overlapping disks
+	double area = ratio * ratio * std::acos(
+		(sep * sep + ratio * ratio - 1.0) / (2.0 * sep * ratio)
+	) + std::acos(
+		(sep * sep + 1.0 - ratio * ratio) / (2.0 * sep)
+	) - 0.5 * std::sqrt(
+		(-sep + ratio + 1.0) * (sep + ratio - 1.0) *
+		(sep - ratio + 1.0) * (sep + ratio + 1.0)
+	);
+	return area / M_PI;
+}
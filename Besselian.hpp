@@ -0,0 +1,228 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef BESSELIAN_HPP
+#define BESSELIAN_HPP
+
+#include "Functions.hpp"
+
+/**
+ * Polynomial Besselian elements for a solar eclipse. The polynomials are in
+ * terms of t, the time in hours (TDT) from @a t0. Coefficients are ordered
+ * from the constant term upward.
+ */
+struct BesselianElements {
+	/**
+	 * Reference time in hours TDT.
+	 */
+	double t0;
+	/**
+	 * TDT - UT in seconds.
+	 */
+	double deltaT;
+	/**
+	 * X coordinate of the shadow axis in Earth radii.
+	 */
+	double x[4];
+	/**
+	 * Y coordinate of the shadow axis in Earth radii.
+	 */
+	double y[4];
+	/**
+	 * Declination of the shadow axis in degrees.
+	 */
+	double d[3];
+	/**
+	 * Greenwich hour angle of the shadow axis in degrees.
+	 */
+	double mu[3];
+	/**
+	 * Radius of the penumbral cone on the fundamental plane.
+	 */
+	double l1[3];
+	/**
+	 * Radius of the umbral cone on the fundamental plane; negative for a
+	 * total eclipse.
+	 */
+	double l2[3];
+	double tanf1;
+	double tanf2;
+};
+
+/**
+ * Besselian elements for the total solar eclipse of April 8, 2024, as
+ * published by Fred Espenak, NASA/GSFC.
+ */
+constexpr BesselianElements Eclipse20240408 = {
+	18.0,
+	69.1,
+	{ -0.318244,  0.5117116,  0.0000326, -0.0000085 },
+	{  0.219764,  0.2709589, -0.0000595, -0.0000047 },
+	{  7.5862,    0.014844,  -0.000002 },
+	{ 89.59122,  15.004080,   0.0 },
+	{  0.535814,  0.0000618, -0.0000128 },
+	{ -0.010272,  0.0000615, -0.0000127 },
+	0.0046683,
+	0.0046450
+};
+
+/**
+ * The eclipse as seen from one location. All times are in seconds from
+ * midnight UTC on the day of the eclipse, the same as used by Umbra.
+ */
+struct LocalCircumstances {
+	/**
+	 * Time of the first contact; start of the partial eclipse.
+	 */
+	double c1;
+	/**
+	 * Time of the second contact; start of totality. Only valid if @a total.
+	 */
+	double c2;
+	/**
+	 * Time of maximum eclipse.
+	 */
+	double max;
+	/**
+	 * Time of the third contact; end of totality. Only valid if @a total.
+	 */
+	double c3;
+	/**
+	 * Time of the fourth contact; end of the partial eclipse.
+	 */
+	double c4;
+	/**
+	 * Fraction of the sun's diameter covered at maximum eclipse.
+	 */
+	double magnitude;
+	/**
+	 * Fraction of the sun's area covered at maximum eclipse.
+	 */
+	double obscuration;
+	/**
+	 * Distance, in Earth radii on the fundamental plane, from the location to
+	 * the edge of the umbra at maximum eclipse. Negative inside the umbra.
+	 * Multiply by about 6378 for a rough value in kilometers.
+	 */
+	double umbraDistance;
+	/**
+	 * True if any part of the eclipse is visible, ignoring the horizon.
+	 */
+	bool partial;
+	/**
+	 * True if the location is inside the path of totality.
+	 */
+	bool total;
+};
+
+/**
+ * The location of the shadow axis on the Earth's surface.
+ */
+struct ShadowPosition {
+	/**
+	 * Where the shadow axis meets the Earth; only valid if @a onEarth.
+	 */
+	Location center;
+	/**
+	 * Approximate radius of the umbra, in kilometers, around @a center.
+	 */
+	double umbraRadius;
+	/**
+	 * Approximate radius of the penumbra, in kilometers, around @a center.
+	 */
+	double penumbraRadius;
+	/**
+	 * True if the shadow axis intersects the Earth.
+	 */
+	bool onEarth;
+};
+
+/**
+ * Evaluates the Besselian element polynomials of an eclipse to find the
+ * approximate circumstances at a location. The results ignore the profile of
+ * the moon's limb and the terrain, so they can be off by a few seconds at a
+ * contact, and by a few kilometers at the edge of the path. That is far less
+ * accurate than the shapes used by Umbra, but it takes only microseconds, so
+ * it works well for deciding when the shapes need not be consulted.
+ *
+ * The implementation follows the method in Jean Meeus' "Elements of Solar
+ * Eclipses 1951-2200".
+ * @author  Jeff Jackowski
+ */
+class Besselian {
+	const BesselianElements &be;
+	/**
+	 * Values used in the computations that depend on the location and time.
+	 */
+	struct Terms;
+	void terms(Terms &t, double rhoSin, double rhoCos, double lon, double hrs)
+	const;
+	double contact(
+		double rhoSin,
+		double rhoCos,
+		double lon,
+		double hrs,
+		bool umbral,
+		double sign
+	) const;
+	/**
+	 * Converts hours (TDT) from t0 into seconds from midnight UTC.
+	 */
+	double utcSeconds(double hrs) const {
+		return (be.t0 + hrs) * 3600.0 - be.deltaT;
+	}
+	/**
+	 * Converts seconds from midnight UTC into hours (TDT) from t0.
+	 */
+	double hours(double sec) const {
+		return (sec + be.deltaT) / 3600.0 - be.t0;
+	}
+public:
+	/**
+	 * Uses the given elements; they must outlive this object.
+	 */
+	constexpr Besselian(const BesselianElements &e = Eclipse20240408) : be(e) { }
+	const BesselianElements &elements() const {
+		return be;
+	}
+	/**
+	 * Computes the eclipse circumstances at the given location.
+	 * @param lc    The results.
+	 * @param loc   The location in degrees.
+	 * @param elev  Elevation above sea level in meters.
+	 * @return      True if the location sees at least a partial eclipse.
+	 */
+	bool local(LocalCircumstances &lc, const Location &loc, double elev = 0)
+	const;
+	/**
+	 * Computes the magnitude and obscuration at one time and place.
+	 * @param mag   The fraction of the sun's diameter covered; zero or less
+	 *              if no eclipse.
+	 * @param obs   The fraction of the sun's area covered.
+	 * @param loc   The location in degrees.
+	 * @param time  Seconds from midnight UTC.
+	 */
+	void coverage(double &mag, double &obs, const Location &loc, double time)
+	const;
+	/**
+	 * Finds where the shadow axis meets the Earth at the given time in seconds
+	 * from midnight UTC.
+	 */
+	void shadow(ShadowPosition &sp, double time) const;
+	/**
+	 * Computes the fraction of the sun's area covered by the moon.
+	 * @param sep    Separation of the centers in solar radii.
+	 * @param ratio  Ratio of the moon's apparent radius to the sun's.
+	 */
+	static double obscuration(double sep, double ratio);
+};
+
+#endif        //  #ifndef BESSELIAN_HPP
@@ -0,0 +1,93 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "ClockMonitor.hpp"
+#include <boost/exception/errinfo_file_name.hpp>
+#include <boost/throw_exception.hpp>
+#include <sys/timex.h>
+#include <algorithm>
+#include <iomanip>
+
+ClockMonitor::ClockMonitor(const std::string &logpath) {
+	samples.reserve(historyLength);
+	if (!logpath.empty()) {
+		log.open(logpath, std::ios::trunc);
+		if (!log) {
+			BOOST_THROW_EXCEPTION(ClockMonitorLogError() <<
+				boost::errinfo_file_name(logpath)
+			);
+		}
+		log << "# time offset error maxerror synced" << std::endl;
+		log << std::fixed;
+	}
+}
+
+bool ClockMonitor::sample() {
+	timex tx = { };
+	int state = adjtimex(&tx);
+	if (state < 0) {
+		return false;
+	}
+	ClockSample cs;
+	cs.time = (double)tx.time.tv_sec;
+	// the kernel reuses the microseconds field for nanoseconds
+	if (tx.status & STA_NANO) {
+		cs.time += (double)tx.time.tv_usec / 1e9;
+		cs.offset = (double)tx.offset / 1e9;
+	} else {
+		cs.time += (double)tx.time.tv_usec / 1e6;
+		cs.offset = (double)tx.offset / 1e6;
+	}
+	cs.maxError = (double)tx.maxerror / 1e6;
+	cs.synced = (state != TIME_ERROR) && !(tx.status & STA_UNSYNC);
+	if (cs.synced) {
+		cs.error = (double)tx.esterror / 1e6;
+	} else {
+		cs.error = cs.maxError;
+	}
+	if (samples.size() < historyLength) {
+		samples.push_back(cs);
+	} else {
+		samples[next] = cs;
+		next = (next + 1) % historyLength;
+	}
+	if (log.is_open()) {
+		log << std::setprecision(3) << cs.time << ' ' << std::setprecision(6) <<
+		cs.offset << ' ' << cs.error << ' ' << cs.maxError << ' ' <<
+		(int)cs.synced << '\n';
+		if (++unflushed >= flushInterval) {
+			log.flush();
+			unflushed = 0;
+		}
+	}
+	return true;
+}
+
+const ClockSample &ClockMonitor::operator[](std::size_t i) const {
+	// once full, the oldest sample is the next to be replaced
+	return samples[(next + i) % samples.size()];
+}
+
+double ClockMonitor::worstError(double seconds) const {
+	double worst = 0;
+	if (samples.empty()) {
+		return worst;
+	}
+	double since = latest().time - seconds;
+	for (std::size_t i = samples.size(); i > 0; --i) {
+		const ClockSample &cs = (*this)[i - 1];
+		if (cs.time < since) {
+			break;
+		}
+		worst = std::max(worst, cs.error);
+	}
+	return worst;
+}
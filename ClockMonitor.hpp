@@ -0,0 +1,125 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef CLOCKMONITOR_HPP
+#define CLOCKMONITOR_HPP
+
+#include <boost/exception/info.hpp>
+#include <boost/noncopyable.hpp>
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct ClockMonitorError : virtual std::exception, virtual boost::exception { };
+/**
+ * The history log file could not be created.
+ */
+struct ClockMonitorLogError : ClockMonitorError { };
+
+/**
+ * The kernel's view of the system clock's discipline at one time.
+ */
+struct ClockSample {
+	/**
+	 * The system time of the sample in seconds since the epoch.
+	 */
+	double time;
+	/**
+	 * The offset being corrected by the kernel, in seconds, as last given
+	 * by NTP.
+	 */
+	double offset;
+	/**
+	 * The likely error of the system clock in seconds. This is the
+	 * estimated error from NTP while synchronized, or the maximum error
+	 * otherwise.
+	 */
+	double error;
+	/**
+	 * The kernel's maximum error bound in seconds.
+	 */
+	double maxError;
+	/**
+	 * True if NTP has synchronized the clock.
+	 */
+	bool synced;
+};
+
+/**
+ * Checks how well NTP has disciplined the system clock by polling
+ * adjtimex() once per second. A history of the samples is kept in memory,
+ * and may also be written to a file to find out afterwards how accurate the
+ * clock was when the alarms sounded.
+ *
+ * The log file has a comment header followed by one line per sample with
+ * the time, offset, error, and maximum error in seconds, and 1 if
+ * synchronized or 0 if not.
+ * @author  Jeff Jackowski
+ */
+class ClockMonitor : boost::noncopyable {
+	/**
+	 * Samples in a circular buffer.
+	 */
+	std::vector<ClockSample> samples;
+	std::ofstream log;
+	/**
+	 * Index of the next sample to replace.
+	 */
+	std::size_t next = 0;
+	/**
+	 * Samples taken since the log was last flushed.
+	 */
+	int unflushed = 0;
+public:
+	/**
+	 * Number of samples kept in memory; four hours.
+	 */
+	static constexpr std::size_t historyLength = 4 * 3600;
+	/**
+	 * Samples written to the log between flushes.
+	 */
+	static constexpr int flushInterval = 60;
+	/**
+	 * Prepares to monitor the clock.
+	 * @param logpath  The file to write the samples to, or an empty string
+	 *                 to only keep them in memory.
+	 * @throw ClockMonitorLogError  The log file could not be created.
+	 */
+	ClockMonitor(const std::string &logpath = std::string());
+	/**
+	 * Samples the clock state now.
+	 * @return  False if the kernel did not provide the state.
+	 */
+	bool sample();
+	/**
+	 * The number of samples in the history.
+	 */
+	std::size_t size() const {
+		return samples.size();
+	}
+	/**
+	 * Returns a sample from the history; zero is the oldest.
+	 */
+	const ClockSample &operator[](std::size_t i) const;
+	/**
+	 * The most recent sample. There must be at least one.
+	 */
+	const ClockSample &latest() const {
+		return (*this)[samples.size() - 1];
+	}
+	/**
+	 * The largest error among the samples taken within the given number of
+	 * seconds before the latest sample, or zero without any samples.
+	 */
+	double worstError(double seconds) const;
+};
+
+#endif        //  #ifndef CLOCKMONITOR_HPP
@@ -12,6 +12,8 @@
 #include "DisplayStuff.hpp"
 
 int DisplayStuff::tzone;
+int DisplayInfo::beforeTotality = 4622;
+int DisplayInfo::afterTotality = 4589;
 
 DisplayInfo::DisplayInfo() : chkloc(0, 0), curloc(0, 0) { }
 
@@ -30,15 +32,17 @@ void DisplayStuff::setTimeOffset(int o) {
 	info.totchg = true;
 }
 
-void DisplayStuff::setCheckLoc(const Location &l) {
+void DisplayStuff::setCheckLoc(const Location &l, bool est) {
 	std::lock_guard<duds::general::Spinlock> lock(block);
 	info.chkloc = l + poff;
+	info.chkest = est;
 	info.chkchg = info.goodfix = true;
 }
 
-void DisplayStuff::setCurrLoc(const Location &l, int le, int su) {
+void DisplayStuff::setCurrLoc(const Location &l, int le, int su, bool est) {
 	std::lock_guard<duds::general::Spinlock> lock(block);
 	info.curloc = l + poff;
+	info.estimated = est;
 	info.locerr = le;
 	info.sats = su;
 	info.poschg = info.goodfix = true;
@@ -96,7 +100,32 @@ void DisplayStuff::setTempData(
 void DisplayStuff::badFix() {
 	std::lock_guard<duds::general::Spinlock> lock(block);
 	info.poschg = true;
-	info.goodfix = false;
+	info.goodfix = info.estimated = false;
+}
+
+void DisplayStuff::setPpsTiming(double offset, double error) {
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	info.ppsOffset = offset;
+	info.ppsError = error;
+}
+
+void DisplayStuff::setClockState(
+	double offset,
+	double error,
+	double worst,
+	bool synced
+) {
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	info.clockOffset = offset;
+	info.clockError = error;
+	info.clockWorst = worst;
+	info.clockSynced = synced;
+}
+
+bool DisplayStuff::contactAhead() {
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	return info.goodfix && info.inTotality &&
+		(info.now < (info.end + DisplayInfo::afterTotality));
 }
 
 void DisplayStuff::updateTotality(int s, int e, bool i) {
@@ -135,6 +164,14 @@ void DisplayStuff::clearError() {
 	info.errormsg.clear();
 }
 
+void DisplayStuff::clearError(const std::string &msg) {
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	if (info.errormsg == msg) {
+		info.errcnt = 0;
+		info.errormsg.clear();
+	}
+}
+
 void DisplayStuff::decError() {
 	std::lock_guard<duds::general::Spinlock> lock(block);
 	if (--info.errcnt <= 0) {
@@ -15,6 +15,7 @@
 #include <duds/general/Spinlock.hpp>
 #include <duds/data/Quantity.hpp>
 #include "Functions.hpp"
+#include <cmath>
 
 struct DisplayInfo {
 	Location chkloc;  // for checked position
@@ -30,6 +31,28 @@ struct DisplayInfo {
 	double rhumexpmovavg = 0;
 	double uv = 0;
 	double uvexpmovavg = 0;
+	/**
+	 * Offset of the system clock from the PPS second in seconds; positive
+	 * when the clock is ahead. Not-a-number without a PPS lock.
+	 */
+	double ppsOffset = NAN;
+	/**
+	 * Timing confidence figure from the PPS input: likely error in seconds
+	 * of the corrected time. Not-a-number without a PPS lock.
+	 */
+	double ppsError = NAN;
+	/**
+	 * Offset in seconds that NTP last gave the kernel to correct.
+	 */
+	double clockOffset = NAN;
+	/**
+	 * Likely error of the system clock in seconds according to the kernel.
+	 */
+	double clockError = NAN;
+	/**
+	 * Largest clock error in seconds seen over the last hour.
+	 */
+	double clockWorst = NAN;
 	int now;    // seconds since midnight UTC
 	int errtime;
 	int notetime;
@@ -50,18 +73,36 @@ struct DisplayInfo {
 	};
 	bool inTotality = false;
 	bool goodfix = false;
+	/**
+	 * The current position was dead reckoned from the last known velocity
+	 * while the GPS has no fix.
+	 */
+	bool estimated = false;
+	/**
+	 * The position of the last totality check was dead reckoned, so the
+	 * totality results are also estimates.
+	 */
+	bool chkest = false;
 	bool test = false;
+	/**
+	 * True when NTP has synchronized the system clock.
+	 */
+	bool clockSynced = false;
 	DisplayInfo();
 	/**
-	 * Kludge for figuring when the eclipse starts; should be good for
-	 * Mount Nebo State Park, Arkansas. Puts the start 1h17m02s before totality.
+	 * Kludge for figuring when the eclipse starts; defaults to a value good
+	 * for Mount Nebo State Park, Arkansas, that puts the start 1h17m02s before
+	 * totality. Replaced by the eclipse catalog entry, if used. Only changed
+	 * before the user interface starts.
 	 */
-	static constexpr int beforeTotality = 4622;
+	static int beforeTotality;
 	/**
-	 * Kludge for figuring when the eclipse ends; should be good for
-	 * Mount Nebo State Park, Arkansas. Puts the end 1h16m29s after totality.
+	 * Kludge for figuring when the eclipse ends; defaults to a value good for
+	 * Mount Nebo State Park, Arkansas, that puts the end 1h16m29s after
+	 * totality. Replaced by the eclipse catalog entry, if used. Only changed
+	 * before the user interface starts.
 	 */
-	static constexpr int afterTotality = 4589;
+	static int afterTotality;
 };
 
 class DisplayStuff {
@@ -77,8 +118,8 @@ public:
 	}
 	void setTime(int time);
 	void setTimeOffset(int o);
-	void setCheckLoc(const Location &l);
-	void setCurrLoc(const Location &l, int le, int su);
+	void setCheckLoc(const Location &l, bool est = false);
+	void setCurrLoc(const Location &l, int le, int su, bool est = false);
 	void setLocOffset(const Location &o);
 	Location getLocOffset();
 	void initBatteryData(
@@ -98,10 +139,22 @@ public:
 		const duds::data::Quantity &relhum
 	);
 	void badFix();
+	void setPpsTiming(double offset, double error);
+	void setClockState(double offset, double error, double worst, bool synced);
+	/**
+	 * True if a contact of the eclipse is yet to come at the current
+	 * location, so accurate time matters.
+	 */
+	bool contactAhead();
 	void updateTotality(int s, int e, bool i);
 	void setError(const std::string msg, int cnt);
 	void setNotice(const std::string msg);
 	void clearError();
+	/**
+	 * Clears the error only if it is still showing @a msg, so that clearing
+	 * one condition does not hide the message of another.
+	 */
+	void clearError(const std::string &msg);
 	void decError();
 	void getInfo(DisplayInfo &di);
 	bool wasGood() const {
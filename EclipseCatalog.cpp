@@ -0,0 +1,113 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "EclipseCatalog.hpp"
+#include <boost/date_time/gregorian/parsers.hpp>
+#include <boost/exception/errinfo_file_name.hpp>
+#include <boost/property_tree/info_parser.hpp>
+#include <filesystem>
+#include <algorithm>
+#include <sstream>
+
+/**
+ * Reads up to @a len space separated polynomial coefficients.
+ */
+static void coefficients(
+	double *coef,
+	int len,
+	const boost::property_tree::ptree &tree,
+	const char *name
+) {
+	std::istringstream iss(tree.get<std::string>(name));
+	for (int i = 0; i < len; ++i) {
+		coef[i] = 0;
+		iss >> coef[i];
+	}
+}
+
+EclipseCatalog::EclipseCatalog(const std::string &dir) {
+	const std::filesystem::path dirpath(dir);
+	std::error_code ec;
+	std::filesystem::directory_iterator diter(dirpath, ec);
+	if (ec) {
+		BOOST_THROW_EXCEPTION(CatalogNoDirectory() <<
+			boost::errinfo_file_name(dir)
+		);
+	}
+	for (auto const &infile : diter) {
+		if (!infile.is_regular_file() || (infile.path().extension() != ".info")) {
+			continue;
+		}
+		boost::property_tree::ptree tree;
+		EclipseEntry ee;
+		ee.name = infile.path().stem().string();
+		try {
+			boost::property_tree::read_info(infile.path().string(), tree);
+			const boost::property_tree::ptree &ecl = tree.get_child("eclipse");
+			ee.date = boost::gregorian::from_simple_string(
+				ecl.get<std::string>("date")
+			);
+			// shapefile is relative to the catalog directory
+			ee.shape = (dirpath / ecl.get<std::string>("shape")).string();
+			ee.layer = ecl.get<std::string>("layer", "umbra_hi");
+			ee.beforeTotality = ecl.get<int>("beforeTotality");
+			ee.afterTotality = ecl.get<int>("afterTotality");
+			boost::optional<const boost::property_tree::ptree &> bes =
+				ecl.get_child_optional("besselian");
+			ee.haveElements = (bool)bes;
+			if (bes) {
+				ee.elements.t0 = bes->get<double>("t0");
+				ee.elements.deltaT = bes->get<double>("deltaT");
+				coefficients(ee.elements.x, 4, *bes, "x");
+				coefficients(ee.elements.y, 4, *bes, "y");
+				coefficients(ee.elements.d, 3, *bes, "d");
+				coefficients(ee.elements.mu, 3, *bes, "mu");
+				coefficients(ee.elements.l1, 3, *bes, "l1");
+				coefficients(ee.elements.l2, 3, *bes, "l2");
+				ee.elements.tanf1 = bes->get<double>("tanf1");
+				ee.elements.tanf2 = bes->get<double>("tanf2");
+			}
+		} catch (...) {
+			BOOST_THROW_EXCEPTION(CatalogBadEntry() <<
+				boost::errinfo_file_name(infile.path().string()) <<
+				CatalogItem(ee.name)
+			);
+		}
+		entries.emplace_back(std::move(ee));
+	}
+	if (entries.empty()) {
+		BOOST_THROW_EXCEPTION(CatalogEmpty() << boost::errinfo_file_name(dir));
+	}
+	std::sort(
+		entries.begin(),
+		entries.end(),
+		[](const EclipseEntry &a, const EclipseEntry &b) {
+			return a.date < b.date;
+		}
+	);
+}
+
+const EclipseEntry &EclipseCatalog::select(
+	const boost::gregorian::date &day
+) const {
+	std::vector<EclipseEntry>::const_iterator iter = std::find_if(
+		entries.cbegin(),
+		entries.cend(),
+		[&day](const EclipseEntry &ee) {
+			return ee.date >= day;
+		}
+	);
+	// all in the past?
+	if (iter == entries.cend()) {
+		return entries.back();
+	}
+	return *iter;
+}
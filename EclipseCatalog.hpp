@@ -0,0 +1,95 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef ECLIPSECATALOG_HPP
+#define ECLIPSECATALOG_HPP
+
+#include <boost/date_time/gregorian/gregorian_types.hpp>
+#include <boost/exception/info.hpp>
+#include <boost/noncopyable.hpp>
+#include "Besselian.hpp"
+#include <vector>
+
+struct CatalogError : virtual std::exception, virtual boost::exception { };
+struct CatalogNoDirectory : CatalogError { };
+struct CatalogEmpty : CatalogError { };
+struct CatalogBadEntry : CatalogError { };
+typedef boost::error_info<struct Info_CatalogItem, std::string>  CatalogItem;
+
+/**
+ * Describes one eclipse and where to find its umbra shapes.
+ */
+struct EclipseEntry {
+	/**
+	 * Name of the metadata file without the extension.
+	 */
+	std::string name;
+	/**
+	 * Full path to the shapefile with the umbra shapes.
+	 */
+	std::string shape;
+	/**
+	 * The name of the layer in the shapefile with the umbra shapes.
+	 */
+	std::string layer;
+	/**
+	 * The date, UTC, of the eclipse.
+	 */
+	boost::gregorian::date date;
+	/**
+	 * The Besselian elements; only valid if @a haveElements is true.
+	 */
+	BesselianElements elements;
+	/**
+	 * Seconds before totality to consider the start of the eclipse; see
+	 * DisplayInfo::beforeTotality.
+	 */
+	int beforeTotality;
+	/**
+	 * Seconds after totality to consider the end of the eclipse; see
+	 * DisplayInfo::afterTotality.
+	 */
+	int afterTotality;
+	bool haveElements;
+};
+
+/**
+ * A directory of umbra datasets for several eclipses. Each eclipse is
+ * described by a file with the extension ".info" in the Boost INFO format,
+ * like the pin configuration file. Only the metadata is read; the shapefile
+ * is left for Umbra to open, so adding more eclipses does not add to startup
+ * time or memory use. See catalog/2024-04-08.info for an example.
+ * @author  Jeff Jackowski
+ */
+class EclipseCatalog : boost::noncopyable {
+	/**
+	 * Eclipses sorted by date.
+	 */
+	std::vector<EclipseEntry> entries;
+public:
+	/**
+	 * Reads the metadata for all eclipses in the given directory.
+	 * @throw CatalogNoDirectory  The directory could not be read.
+	 * @throw CatalogEmpty        No eclipses were found.
+	 * @throw CatalogBadEntry     A metadata file lacks a required item.
+	 */
+	EclipseCatalog(const std::string &dir);
+	/**
+	 * Returns the eclipse on or soonest after the given date. If all eclipses
+	 * are in the past, the most recent is returned.
+	 */
+	const EclipseEntry &select(const boost::gregorian::date &day) const;
+	const std::vector<EclipseEntry> &eclipses() const {
+		return entries;
+	}
+};
+
+#endif        //  #ifndef ECLIPSECATALOG_HPP
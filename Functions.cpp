@@ -10,6 +10,7 @@
  * Copyright (C) 2024  Jeff Jackowski
  */
 #include "Functions.hpp"
+#include "Trace.hpp"
 #include <cmath>
 #include <boost/date_time/gregorian/gregorian_types.hpp>
 #include <duds/time/planetary/Planetary.hpp>
@@ -43,13 +44,15 @@ void sunPosition_old(
 	const duds::time::interstellar::SecondTime &time
 ) {
 	boost::gregorian::date date = duds::time::planetary::earth->date(time);
-	int ls = duds::time::planetary::earth->leaps.leapSeconds(time).count();
 	// based on https://www.esrl.noaa.gov/gmd/grad/solcalc/solareqns.PDF
-	// start of 2017 is at 1483228827s after T0
-	// 2017 has no leap seconds or days
-	// 1704153627 for start of 2024
+	// start of the year; no longer a constant for 2017 or 2024
+	duds::time::interstellar::SecondTime yearStartTime;
+	duds::time::planetary::earth->date(
+		yearStartTime,
+		boost::gregorian::date(date.year(), 1, 1)
+	);
 	double y = 2.0 * M_PI * (
-		(double)(time.time_since_epoch().count() - 1704153627 - ls) /
+		(double)(time - yearStartTime).count() /
 		(double)(60 * 60 * 24 * 365) // one year
 	);
 	double eqtime = 229.18 * (0.000075 + 0.001868 * std::cos(y) -
@@ -92,18 +95,14 @@ double degrees(double r) {
 	return r * 180.0 / M_PI;
 }
 
-void sunPosition(
-	double &azimuth,
-	double &elevation,
-	const Location &loc,
-	const duds::time::interstellar::SecondTime &time
-) {
+/**
+ * Returns the fractional Julian day for the given time.
+ */
+static double julianDay(const duds::time::interstellar::SecondTime &time) {
 	boost::gregorian::date date = duds::time::planetary::earth->date(time);
 	// start of day time
 	duds::time::interstellar::SecondTime dayStartTime;
 	duds::time::planetary::earth->date(dayStartTime, date);
-	// converted from a NOAA spreadsheet, including many conversions between
-	// radians and degrees to avoid introducing errors
 	// Time of current day as a fraction of how much of the day has past.
 	double e2 = (double)(time - dayStartTime).count() / (60.0 * 60.0 * 24.0);
 	// The spreadsheet handles dates like a day number. This is the number used
@@ -112,7 +111,19 @@ void sunPosition(
 	// use above to compute the spreadsheet's version of the date
 	//double d2 =
 	// fractional Julian day
-	double f2 = (double)date.day_number() - 0.5 + e2;
+	return (double)date.day_number() - 0.5 + e2;
+}
+
+/**
+ * Computes the declination and equation of time from the fractional Julian
+ * day. Converted from a NOAA spreadsheet, including many conversions between
+ * radians and degrees to avoid introducing errors. The variable names are the
+ * cells of the spreadsheet.
+ * @param decl    The declination in degrees.
+ * @param eqtime  The equation of time in minutes.
+ * @param f2      The fractional Julian day.
+ */
+static void sunTerms(double &decl, double &eqtime, double f2) {
 	double g2 = (f2 - 2451545.0) / 36525.0;
 	double i2 = std::fmod(280.46646 + g2 * (36000.76983 + g2 * 0.0003032), 360.0);
 	double j2 = 357.52911 + g2 * (35999.05029 - 0.0001537 * g2);
@@ -125,26 +136,117 @@ void sunPosition(
 	double q2 = 23.0 + (26.0 + ((21.448 - g2 * (46.815 + g2 *
 		(0.00059 - g2 * 0.001813)))) / 60.0) / 60.0;
 	double r2 = q2 + 0.00256 * std::cos(radians(125.04 - 1934.136 * g2));
-	double t2 = degrees(std::asin(std::sin(radians(r2)) * std::sin(radians(p2))));
+	decl = degrees(std::asin(std::sin(radians(r2)) * std::sin(radians(p2))));
 	double u2 = std::tan(radians(r2 / 2.0)) * std::tan(radians(r2 / 2.0));
-	double v2 = 4.0 * degrees(u2 * std::sin(2.0 * radians(i2)) - 2.0 * k2
+	eqtime = 4.0 * degrees(u2 * std::sin(2.0 * radians(i2)) - 2.0 * k2
 		* std::sin(radians(j2)) + 4.0 * k2 * u2 * std::sin(radians(j2))
 		* std::cos(2.0 * radians(i2)) - 0.5 * u2 * u2 * std::sin(4.0 * radians(i2))
 		- 1.25 * k2 * k2 * std::sin(2.0 * radians(j2)));
+}
+
+void sunTerms(SunTerms &st, double julianDay) {
+	double decl;
+	sunTerms(decl, st.eqtime, julianDay);
+	st.decl = radians(decl);
+}
+
+void sunTerms(SunTerms &st, const duds::time::interstellar::SecondTime &time) {
+	sunTerms(st, julianDay(time));
+}
+
+void sunPosition(
+	double &azimuth,
+	double &elevation,
+	const Location &loc,
+	const duds::time::interstellar::SecondTime &time
+) {
+	TRACE_SPAN("sunPosition");
+	double f2 = julianDay(time);
+	// fraction of the day
+	double e2 = f2 + 0.5 - std::floor(f2 + 0.5);
+	double t2, v2;
+	sunTerms(t2, v2, f2);
 	double ab2 = std::fmod(e2 * 1440.0 + v2 + 4.0 * loc.lon, 1440.0);
 	double ac2 = ((ab2 / 4.0) < 0) ? (ab2 / 4.0 + 180.0) : (ab2 / 4.0 - 180.0);
 	double ad2 = degrees(std::acos(std::sin(radians(loc.lat))
 		* std::sin(radians(t2)) + std::cos(radians(loc.lat))
 		* std::cos(radians(t2)) * std::cos(radians(ac2))));
 	elevation = 90.0 - ad2;
-	if (ac2 > 0) {
-		azimuth = std::fmod(degrees(std::acos(((std::sin(radians(loc.lat))
-			* cos(radians(ad2))) - sin(radians(t2))) / (cos(radians(loc.lat))
-			* sin(radians(ad2))))) + 180.0, 360.0);
+	// The spreadsheet uses an arccosine here, which needs the sign of the hour
+	// angle to pick the side and goes out of its domain with the sun near the
+	// zenith. The arctangent handles both.
+	azimuth = degrees(std::atan2(
+		std::sin(radians(ac2)),
+		std::cos(radians(ac2)) * std::sin(radians(loc.lat)) -
+		std::tan(radians(t2)) * std::cos(radians(loc.lat))
+	)) + 180.0;
+}
+
+void sunPositions(
+	double *azimuth,
+	double *elevation,
+	const Location &loc,
+	const duds::time::interstellar::SecondTime &start,
+	duds::time::interstellar::Seconds step,
+	int count
+) {
+	if (count <= 0) {
+		return;
+	}
+	TRACE_SPAN("sunPositions");
+	// slow terms at both ends of the span
+	double f2 = julianDay(start);
+	double decl0, eqt0, decl1, eqt1;
+	sunTerms(decl0, eqt0, f2);
+	double stepMin = (double)step.count() / 60.0;
+	if (count > 1) {
+		sunTerms(
+			decl1,
+			eqt1,
+			f2 + stepMin * (double)(count - 1) / 1440.0
+		);
+	} else {
+		decl1 = decl0;
+		eqt1 = eqt0;
+	}
+	// Interpolate the sine and cosine of the declination rather than the
+	// declination to keep trig functions out of the loop. The declination
+	// changes by less than half a degree per day, so the error is negligible.
+	double div = (count > 1) ? (double)(count - 1) : 1.0;
+	double sinDecl = std::sin(radians(decl0));
+	double cosDecl = std::cos(radians(decl0));
+	double sinDeclStep = (std::sin(radians(decl1)) - sinDecl) / div;
+	double cosDeclStep = (std::cos(radians(decl1)) - cosDecl) / div;
+	double sinLat = std::sin(radians(loc.lat));
+	double cosLat = std::cos(radians(loc.lat));
+	// hour angle in radians for the first time; no need to keep it within a
+	// single revolution since it is only used with trig functions
+	double ha = radians(
+		(f2 + 0.5 - std::floor(f2 + 0.5)) * 360.0 + eqt0 / 4.0 + loc.lon - 180.0
+	);
+	double haStep = radians((stepMin + (eqt1 - eqt0) / div) / 4.0);
+	// Each iteration is independent of the others so the compiler is free to
+	// vectorize the loops.
+	if (azimuth) {
+		for (int i = 0; i < count; ++i) {
+			double h = ha + haStep * (double)i;
+			double sd = sinDecl + sinDeclStep * (double)i;
+			double cd = cosDecl + cosDeclStep * (double)i;
+			double ch = std::cos(h);
+			elevation[i] = degrees(std::asin(sinLat * sd + cosLat * cd * ch));
+			// measured clockwise from north
+			azimuth[i] = degrees(std::atan2(
+				std::sin(h), ch * sinLat - sd / cd * cosLat
+			)) + 180.0;
+		}
 	} else {
-		azimuth = std::fmod(540.0 - degrees(acos(((sin(radians(loc.lat))
-			* cos(radians(ad2))) - sin(radians(t2))) / (cos(radians(loc.lat))
-			* sin(radians(ad2))))), 360.0);
+		for (int i = 0; i < count; ++i) {
+			double h = ha + haStep * (double)i;
+			double sd = sinDecl + sinDeclStep * (double)i;
+			double cd = cosDecl + cosDeclStep * (double)i;
+			elevation[i] = degrees(std::asin(sinLat * sd + cosLat * cd *
+				std::cos(h)));
+		}
 	}
 }
 
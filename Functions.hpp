@@ -9,6 +9,9 @@
  *
  * Copyright (C) 2024  Jeff Jackowski
  */
+#ifndef FUNCTIONS_HPP
+#define FUNCTIONS_HPP
+
 #include <duds/time/interstellar/Interstellar.hpp>
 #include <iostream>
 
@@ -59,22 +62,77 @@ double haversineEarth(const Location &l0, const Location &l1);
 
 /**
  * Computes the azimuth and elevation of the sun for the given time and
- * location on Earth. The implementation is based on the text at:
- * https://www.esrl.noaa.gov/gmd/grad/solcalc/solareqns.PDF
+ * location on Earth. The implementation is converted from the NOAA solar
+ * calculation spreadsheet, which does not account for atmospheric refraction.
  *
- * This isn't the most accurate computation, but I hope it'll be good enough
- * for me. The values for mid-totality for elevation are within a couple degrees
- * or so. Azimuth is only good somewhere east of longitude -93 degrees; I have
- * no idea why. Elevation values generally seem good, but azimuth values are bad
- * for anywhere and anytime other than east of -93 during totality.
+ * An earlier version based on the text at
+ * https://www.esrl.noaa.gov/gmd/grad/solcalc/solareqns.PDF gave a bad azimuth
+ * west of about -93 degrees longitude because the arccosine it used cannot
+ * tell east from west. The azimuth is now found with the arctangent of the
+ * hour angle, which is good everywhere.
+ * @param azimuth    Degrees clockwise from north.
+ * @param elevation  Degrees above the horizon.
  */
 void sunPosition(
-	double &azimuth,    // bad result
-	double &elevation,  // usable result
+	double &azimuth,
+	double &elevation,
 	const Location &loc,
 	const duds::time::interstellar::SecondTime &time
 );
 
+/**
+ * The terms of the sun's position that change slowly; they depend only on the
+ * time and not the location. Over a span of hours they change little enough
+ * to be interpolated, which is what allows sunPositions() to be fast.
+ */
+struct SunTerms {
+	/**
+	 * Declination of the sun in radians.
+	 */
+	double decl;
+	/**
+	 * Equation of time in minutes.
+	 */
+	double eqtime;
+};
+
+/**
+ * Computes the declination and equation of time for the given time using the
+ * same NOAA spreadsheet computations as sunPosition().
+ */
+void sunTerms(SunTerms &st, const duds::time::interstellar::SecondTime &time);
+
+/**
+ * Computes the declination and equation of time for the given fractional
+ * Julian day.
+ */
+void sunTerms(SunTerms &st, double julianDay);
+
+/**
+ * Computes the azimuth and elevation of the sun for @a count times starting at
+ * @a start and spaced @a step apart, all for the same location. The slowly
+ * changing terms are only computed for the first and last times and are
+ * interpolated in between, so the work per time is a few trig functions
+ * rather than the whole computation done by sunPosition(). The interpolation
+ * error is well under a hundredth of a degree for spans of a day or less.
+ * @param azimuth    Array of at least @a count values for the azimuth
+ *                   results, or nullptr if azimuth is not needed.
+ * @param elevation  Array of at least @a count values for the elevation
+ *                   results.
+ * @param loc        The location on Earth.
+ * @param start      The time of the first result.
+ * @param step       The time between results.
+ * @param count      The number of results to compute.
+ */
+void sunPositions(
+	double *azimuth,
+	double *elevation,
+	const Location &loc,
+	const duds::time::interstellar::SecondTime &start,
+	duds::time::interstellar::Seconds step,
+	int count
+);
+
 /**
  * Hours-minutes-seconds; needed for displaying time durations.
  */
@@ -96,3 +154,5 @@ struct Hms {
 	void writeTime(std::ostream &os) const;
 	std::string time() const;
 };
+
+#endif        //  #ifndef FUNCTIONS_HPP
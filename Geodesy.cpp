@@ -0,0 +1,128 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "Geodesy.hpp"
+#include <cmath>
+
+// WGS 84
+static constexpr double semiMajor = 6378137.0;
+static constexpr double flattening = 1.0 / 298.257223563;
+static constexpr double semiMinor = semiMajor * (1.0 - flattening);
+static constexpr double eccSq = flattening * (2.0 - flattening);
+
+static constexpr double radPerDeg = M_PI / 180.0;
+
+double Enu::horizontal() const {
+	return std::sqrt(east * east + north * north);
+}
+
+void LocalFrame::anchor(const Location &anchor, double altitude) {
+	orig = anchor;
+	alt0 = altitude;
+	double lat = anchor.lat * radPerDeg;
+	sinLat = std::sin(lat);
+	double cosLat = std::cos(lat);
+	double w2 = 1.0 - eccSq * sinLat * sinLat;
+	double w = std::sqrt(w2);
+	double prime = semiMajor / w;
+	merid = semiMajor * (1.0 - eccSq) / (w2 * w);
+	meridRate = 3.0 * semiMajor * (1.0 - eccSq) * eccSq * sinLat * cosLat /
+		(w2 * w2 * w);
+	parallel = prime * cosLat;
+	radius = std::sqrt(merid * prime);
+}
+
+Enu LocalFrame::toEnu(const Location &loc, double altitude) const {
+	double dlat = (loc.lat - orig.lat) * radPerDeg;
+	double dlon = std::remainder(loc.lon - orig.lon, 360.0) * radPerDeg;
+	// The parallels get shorter moving toward the pole, and the meridians
+	// converge, which bends the parallel through the origin toward the pole
+	// as seen from the plane.
+	Enu pos(
+		(parallel - merid * sinLat * dlat) * dlon,
+		(merid + 0.5 * meridRate * dlat) * dlat +
+			0.5 * parallel * sinLat * dlon * dlon
+	);
+	// the Earth drops away from the plane
+	pos.up = altitude - alt0 -
+		(pos.east * pos.east + pos.north * pos.north) / (2.0 * radius);
+	return pos;
+}
+
+Location LocalFrame::toLocation(const Enu &pos) const {
+	// first order, then refine with the second order terms from toEnu()
+	double dlat = pos.north / merid;
+	double dlon = pos.east / parallel;
+	for (int i = 0; i < 2; ++i) {
+		dlat = (pos.north - 0.5 * parallel * sinLat * dlon * dlon) /
+			(merid + 0.5 * meridRate * dlat);
+		dlon = pos.east / (parallel - merid * sinLat * dlat);
+	}
+	return Location(
+		orig.lon + dlon / radPerDeg,
+		orig.lat + dlat / radPerDeg
+	);
+}
+
+double LocalFrame::distance(const Location &loc) const {
+	double d = toEnu(loc).horizontal();
+	if (d > range) {
+		return vincentyEarth(orig, loc);
+	}
+	return d;
+}
+
+double vincentyEarth(const Location &l0, const Location &l1) {
+	double L = std::remainder(l1.lon - l0.lon, 360.0) * radPerDeg;
+	// reduced latitudes
+	double U1 = std::atan((1.0 - flattening) * std::tan(l0.lat * radPerDeg));
+	double U2 = std::atan((1.0 - flattening) * std::tan(l1.lat * radPerDeg));
+	double sinU1 = std::sin(U1), cosU1 = std::cos(U1);
+	double sinU2 = std::sin(U2), cosU2 = std::cos(U2);
+	double lambda = L, lambdaPrev;
+	double sinSigma, cosSigma, sigma, cosSqAlpha, cos2SigmaM;
+	int iter = 0;
+	do {
+		double sinLambda = std::sin(lambda), cosLambda = std::cos(lambda);
+		double t0 = cosU2 * sinLambda;
+		double t1 = cosU1 * sinU2 - sinU1 * cosU2 * cosLambda;
+		sinSigma = std::sqrt(t0 * t0 + t1 * t1);
+		if (sinSigma == 0) {
+			// same point
+			return 0;
+		}
+		cosSigma = sinU1 * sinU2 + cosU1 * cosU2 * cosLambda;
+		sigma = std::atan2(sinSigma, cosSigma);
+		double sinAlpha = cosU1 * cosU2 * sinLambda / sinSigma;
+		cosSqAlpha = 1.0 - sinAlpha * sinAlpha;
+		// zero on the equator
+		cos2SigmaM = (cosSqAlpha != 0) ?
+			(cosSigma - 2.0 * sinU1 * sinU2 / cosSqAlpha) : 0;
+		double C = flattening / 16.0 * cosSqAlpha *
+			(4.0 + flattening * (4.0 - 3.0 * cosSqAlpha));
+		lambdaPrev = lambda;
+		lambda = L + (1.0 - C) * flattening * sinAlpha * (sigma + C * sinSigma *
+			(cos2SigmaM + C * cosSigma * (-1.0 + 2.0 * cos2SigmaM * cos2SigmaM)));
+	} while ((std::fabs(lambda - lambdaPrev) > 1e-12) && (++iter < 100));
+	if (iter >= 100) {
+		return haversineEarth(l0, l1);
+	}
+	double uSq = cosSqAlpha * (semiMajor * semiMajor - semiMinor * semiMinor) /
+		(semiMinor * semiMinor);
+	double A = 1.0 + uSq / 16384.0 * (4096.0 + uSq * (-768.0 + uSq *
+		(320.0 - 175.0 * uSq)));
+	double B = uSq / 1024.0 * (256.0 + uSq * (-128.0 + uSq * (74.0 - 47.0 * uSq)));
+	double deltaSigma = B * sinSigma * (cos2SigmaM + B / 4.0 * (cosSigma *
+		(-1.0 + 2.0 * cos2SigmaM * cos2SigmaM) - B / 6.0 * cos2SigmaM *
+		(-3.0 + 4.0 * sinSigma * sinSigma) * (-3.0 + 4.0 * cos2SigmaM *
+		cos2SigmaM)));
+	return semiMinor * A * (sigma - deltaSigma);
+}
@@ -0,0 +1,128 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef GEODESY_HPP
+#define GEODESY_HPP
+
+#include "Functions.hpp"
+
+/**
+ * A position in meters in a local East-North-Up frame.
+ */
+struct Enu {
+	double east;
+	double north;
+	double up;
+	Enu() = default;
+	constexpr Enu(double e, double n, double u = 0) :
+		east(e), north(n), up(u) { }
+	Enu operator + (const Enu &p) const {
+		return Enu(east + p.east, north + p.north, up + p.up);
+	}
+	Enu operator - (const Enu &p) const {
+		return Enu(east - p.east, north - p.north, up - p.up);
+	}
+	Enu operator * (double s) const {
+		return Enu(east * s, north * s, up * s);
+	}
+	/**
+	 * Distance in meters along the ground, ignoring the up component.
+	 */
+	double horizontal() const;
+};
+
+/**
+ * A local tangent plane on the WGS 84 ellipsoid anchored at a reference
+ * location. Conversions to and from the frame are a handful of multiply-adds
+ * using coefficients computed by anchor(), so they are cheap enough for every
+ * GPS fix. They include the second order terms, which keeps the error to
+ * centimeters within @a range of the anchor. Farther than that, the frame
+ * should be re-anchored; distance() falls back to vincentyEarth() so that
+ * callers need not check.
+ * @author  Jeff Jackowski
+ */
+class LocalFrame {
+	/**
+	 * The anchor point.
+	 */
+	Location orig;
+	/**
+	 * Altitude of the anchor point in meters.
+	 */
+	double alt0;
+	/**
+	 * Meridian radius of curvature, and its change with latitude, in meters
+	 * per radian.
+	 */
+	double merid, meridRate;
+	/**
+	 * Radius of the parallel through the anchor in meters.
+	 */
+	double parallel;
+	/**
+	 * Sine of the anchor's latitude.
+	 */
+	double sinLat;
+	/**
+	 * Mean radius of curvature for the drop of the Earth below the plane.
+	 */
+	double radius;
+public:
+	/**
+	 * Distance in meters from the anchor where the frame is still accurate.
+	 */
+	static constexpr double range = 20000.0;
+	LocalFrame() : LocalFrame(Location(0, 0)) { }
+	LocalFrame(const Location &anchor, double altitude = 0) {
+		this->anchor(anchor, altitude);
+	}
+	/**
+	 * Moves the frame's origin to the given location.
+	 */
+	void anchor(const Location &anchor, double altitude = 0);
+	/**
+	 * The location of the frame's origin.
+	 */
+	const Location &origin() const {
+		return orig;
+	}
+	/**
+	 * Converts a location into the frame.
+	 */
+	Enu toEnu(const Location &loc, double altitude = 0) const;
+	/**
+	 * Converts a position in the frame back to a location; the inverse of
+	 * toEnu().
+	 */
+	Location toLocation(const Enu &pos) const;
+	/**
+	 * True if the location is too far from the origin for good accuracy.
+	 */
+	bool outOfRange(const Location &loc) const {
+		return toEnu(loc).horizontal() > range;
+	}
+	/**
+	 * Returns the distance in meters along the ground from the origin to the
+	 * location.
+	 */
+	double distance(const Location &loc) const;
+};
+
+/**
+ * Returns the distance in meters between two locations on the WGS 84
+ * ellipsoid using Vincenty's inverse formula. Accurate to well under a
+ * millimeter, but slower than haversineEarth(). Falls back to
+ * haversineEarth() for nearly antipodal locations, where the iteration does
+ * not converge.
+ */
+double vincentyEarth(const Location &l0, const Location &l1);
+
+#endif        //  #ifndef GEODESY_HPP
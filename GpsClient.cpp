@@ -0,0 +1,302 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "GpsClient.hpp"
+#include "Trace.hpp"
+#include <boost/throw_exception.hpp>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+/**
+ * The command to start receiving JSON reports.
+ */
+static const char watchCmd[] = "?WATCH={\"enable\":true,\"json\":true};\n";
+
+/**
+ * Finds the value of a key in a line of JSON.
+ * @return  A pointer to the start of the value, or nullptr if the key is
+ *          not in the line.
+ */
+static const char *findValue(const char *line, const char *key) {
+	std::size_t len = std::strlen(key);
+	const char *pos = line;
+	while ((pos = std::strchr(pos, '"')) != nullptr) {
+		++pos;
+		if (
+			(std::strncmp(pos, key, len) == 0) &&
+			(pos[len] == '"') && (pos[len + 1] == ':')
+		) {
+			return pos + len + 2;
+		}
+	}
+	return nullptr;
+}
+
+/**
+ * Reads a number from a line of JSON. The value is unchanged if the key is
+ * absent.
+ */
+static void number(double &val, const char *line, const char *key) {
+	const char *pos = findValue(line, key);
+	if (pos) {
+		char *end;
+		double v = std::strtod(pos, &end);
+		if (end != pos) {
+			val = v;
+		}
+	}
+}
+
+static void number(int &val, const char *line, const char *key) {
+	double v = NAN;
+	number(v, line, key);
+	if (std::isfinite(v)) {
+		val = (int)v;
+	}
+}
+
+/**
+ * Reads an ISO 8601 time, as used by gpsd, into seconds since the Unix epoch.
+ */
+static void isoTime(double &val, const char *line, const char *key) {
+	const char *pos = findValue(line, key);
+	std::tm t;
+	double sec;
+	if (pos && (std::sscanf(
+		pos,
+		"\"%d-%d-%dT%d:%d:%lf",
+		&t.tm_year, &t.tm_mon, &t.tm_mday, &t.tm_hour, &t.tm_min, &sec
+	) == 6)) {
+		t.tm_year -= 1900;
+		t.tm_mon -= 1;
+		t.tm_sec = 0;
+		t.tm_isdst = 0;
+		val = (double)timegm(&t) + sec;
+	}
+}
+
+/**
+ * Returns the real-time clock in seconds since the Unix epoch.
+ */
+static double realTime() {
+	timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+GpsClient::GpsClient(
+	duds::os::linux::Poller &p,
+	const GpsFixHandler &h,
+	const std::string &hostname,
+	const std::string &portname
+) : poller(p), handler(h),
+timer(p, std::bind(&GpsClient::expired, this)) {
+	addrinfo hints = { };
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if (getaddrinfo(hostname.c_str(), portname.c_str(), &hints, &addrs) != 0) {
+		BOOST_THROW_EXCEPTION(GpsClientResolveError() <<
+			GpsClientHost(hostname) << GpsClientPort(portname)
+		);
+	}
+	connect();
+}
+
+GpsClient::~GpsClient() {
+	if (sock >= 0) {
+		poller.remove(sock);
+		close(sock);
+	}
+	freeaddrinfo(addrs);
+}
+
+void GpsClient::connect() {
+	nextAddr = addrs;
+	attempt();
+}
+
+void GpsClient::attempt() {
+	// localhost may give IPv6 first while gpsd only listens on IPv4, or the
+	// other way around
+	while (nextAddr) {
+		addrinfo *ai = nextAddr;
+		nextAddr = ai->ai_next;
+		sock = socket(
+			ai->ai_family,
+			ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+			ai->ai_protocol
+		);
+		if (sock < 0) {
+			continue;
+		}
+		used = 0;
+		if (::connect(sock, ai->ai_addr, ai->ai_addrlen) == 0) {
+			poller.add(this, sock, EPOLLIN);
+			established();
+			return;
+		}
+		if (errno == EINPROGRESS) {
+			// wait for the socket to become writable
+			state = Connecting;
+			poller.add(this, sock, EPOLLOUT);
+			timer.once(staleTime);
+			return;
+		}
+		close(sock);
+		sock = -1;
+	}
+	state = Disconnected;
+	timer.once(retryDelay);
+}
+
+void GpsClient::disconnect() {
+	if (sock >= 0) {
+		poller.remove(sock);
+		close(sock);
+		sock = -1;
+	}
+	state = Disconnected;
+	timer.once(retryDelay);
+}
+
+void GpsClient::established() {
+	// the request is much smaller than the socket buffer, so it will not
+	// block or be split
+	if (send(sock, watchCmd, sizeof(watchCmd) - 1, MSG_NOSIGNAL) !=
+		(ssize_t)(sizeof(watchCmd) - 1)
+	) {
+		disconnect();
+		return;
+	}
+	state = Connected;
+	timer.once(staleTime);
+}
+
+void GpsClient::receive() {
+	ssize_t len;
+	while ((len = recv(sock, buffer + used, sizeof(buffer) - used - 1, 0)) > 0) {
+		timer.once(staleTime);
+		used += len;
+		buffer[used] = 0;
+		// parse each complete line
+		char *line = buffer;
+		char *eol;
+		while ((eol = std::strchr(line, '\n')) != nullptr) {
+			*eol = 0;
+			parse(line);
+			line = eol + 1;
+		}
+		// keep the partial line
+		used -= line - buffer;
+		if (used == (sizeof(buffer) - 1)) {
+			// too long to be a report
+			used = 0;
+		} else if (used && (line != buffer)) {
+			std::memmove(buffer, line, used);
+		}
+	}
+	// closed, or an error other than having read everything?
+	if ((len == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK))) {
+		disconnect();
+	}
+}
+
+void GpsClient::parse(const char *line) {
+	const char *cls = findValue(line, "class");
+	if (!cls) {
+		return;
+	}
+	if (std::strncmp(cls, "\"SKY\"", 5) == 0) {
+		int count = -1;
+		number(count, line, "uSat");
+		if (count < 0) {
+			// older versions of gpsd only mark each satellite
+			count = 0;
+			for (
+				const char *pos = findValue(line, "used");
+				pos;
+				pos = findValue(pos, "used")
+			) {
+				if (std::strncmp(pos, "true", 4) == 0) {
+					++count;
+				}
+			}
+		}
+		satellites = count;
+	} else if (std::strncmp(cls, "\"TPV\"", 5) == 0) {
+		GpsFix fix;
+		fix.arrival = realTime();
+		fix.satellites = satellites;
+		number(fix.mode, line, "mode");
+		// gpsd leaves out the status for a normal fix
+		fix.status = (fix.mode >= 2) ? 1 : 0;
+		number(fix.status, line, "status");
+		isoTime(fix.time, line, "time");
+		number(fix.loc.lat, line, "lat");
+		number(fix.loc.lon, line, "lon");
+		number(fix.altitude, line, "altHAE");
+		if (!std::isfinite(fix.altitude)) {
+			number(fix.altitude, line, "alt");
+		}
+		number(fix.epx, line, "epx");
+		number(fix.epy, line, "epy");
+		number(fix.speed, line, "speed");
+		number(fix.track, line, "track");
+		number(fix.eps, line, "eps");
+		handler(fix);
+	}
+}
+
+void GpsClient::expired() {
+	if (state == Disconnected) {
+		connect();
+	} else if (state == Connecting) {
+		// took too long; try the next address
+		poller.remove(sock);
+		close(sock);
+		sock = -1;
+		attempt();
+	} else {
+		// silent
+		disconnect();
+	}
+}
+
+void GpsClient::respond(duds::os::linux::Poller *, int fd) {
+	TRACE_SPAN("GpsClient::respond");
+	if (fd == sock) {
+		if (state == Connecting) {
+			int err = 0;
+			socklen_t len = sizeof(err);
+			getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len);
+			if (err) {
+				// refused or unreachable; try the next address
+				poller.remove(sock);
+				close(sock);
+				sock = -1;
+				attempt();
+				return;
+			}
+			// stop waiting for writability
+			poller.remove(sock);
+			poller.add(this, sock, EPOLLIN);
+			established();
+		} else {
+			receive();
+		}
+	}
+}
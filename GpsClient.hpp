@@ -0,0 +1,159 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef GPSCLIENT_HPP
+#define GPSCLIENT_HPP
+
+#include <boost/exception/info.hpp>
+#include "GpsSource.hpp"
+#include "TimerFd.hpp"
+#include <chrono>
+#include <string>
+
+struct addrinfo;
+
+struct GpsClientError : virtual std::exception, virtual boost::exception { };
+/**
+ * The host or port of gpsd could not be resolved.
+ */
+struct GpsClientResolveError : GpsClientError { };
+typedef boost::error_info<struct Info_GpsdHost, std::string>  GpsClientHost;
+typedef boost::error_info<struct Info_GpsdPort, std::string>  GpsClientPort;
+
+/**
+ * A non-blocking client for gpsd's JSON protocol. The socket and a timer are
+ * registered with a Poller, so reports are handled as they arrive by the
+ * thread waiting on the Poller, and nothing ever blocks waiting on gpsd.
+ *
+ * Only TPV and SKY reports are parsed, and only for the fields in GpsFix;
+ * the satellite count from SKY is kept for the following TPV reports. The
+ * parsing is a simple search for the needed keys in each line rather than a
+ * full JSON parser, which is enough for gpsd's flat TPV objects and avoids
+ * allocating memory for every report.
+ *
+ * The timer handles reconnecting. If the connection fails, or no data
+ * arrives for @a staleTime, the socket is closed and a new connection is
+ * attempted after @a retryDelay.
+ *
+ * The host is resolved only once, by the constructor, because
+ * getaddrinfo() blocks and the Poller's thread must not wait on the
+ * resolver. The constructor may block on it, so the host should be a
+ * numeric address or a name in /etc/hosts, like the default. The addresses
+ * are kept and tried in order on each connection attempt.
+ * @author  Jeff Jackowski
+ */
+class GpsClient : public GpsSource {
+	duds::os::linux::Poller &poller;
+	GpsFixHandler handler;
+	/**
+	 * Received data not yet parsed; always holds whole lines once parsed.
+	 */
+	char buffer[8192];
+	/**
+	 * Number of bytes in @a buffer.
+	 */
+	std::size_t used = 0;
+	/**
+	 * The addresses of gpsd.
+	 */
+	addrinfo *addrs = nullptr;
+	/**
+	 * The next address in @a addrs to try.
+	 */
+	addrinfo *nextAddr = nullptr;
+	/**
+	 * The socket connected to gpsd, or -1.
+	 */
+	int sock = -1;
+	/**
+	 * The timer for reconnecting and noticing silence.
+	 */
+	TimerFd timer;
+	/**
+	 * Satellites used as of the last SKY report.
+	 */
+	int satellites = 0;
+	enum State {
+		Disconnected,
+		Connecting,
+		Connected
+	};
+	State state = Disconnected;
+	/**
+	 * Connects again, or gives up on a slow connection or a silent gpsd.
+	 */
+	void expired();
+	/**
+	 * Starts connecting to the first address of gpsd.
+	 */
+	void connect();
+	/**
+	 * Starts a connection to the next address that does not fail
+	 * immediately. Once out of addresses, arms the timer for another try.
+	 */
+	void attempt();
+	/**
+	 * Closes the socket and arms the timer for another attempt.
+	 */
+	void disconnect();
+	/**
+	 * Finishes a connection once the socket is writable and requests reports.
+	 */
+	void established();
+	/**
+	 * Reads everything available from the socket and parses complete lines.
+	 */
+	void receive();
+	/**
+	 * Parses one line; it must be followed by a null character.
+	 */
+	void parse(const char *line);
+public:
+	/**
+	 * Time to wait after a failure before connecting again.
+	 */
+	static constexpr std::chrono::milliseconds retryDelay =
+		std::chrono::milliseconds(2000);
+	/**
+	 * Time without any data from gpsd before the connection is presumed bad.
+	 * gpsd normally sends reports every second.
+	 */
+	static constexpr std::chrono::milliseconds staleTime =
+		std::chrono::milliseconds(10000);
+	/**
+	 * Makes the client and starts connecting.
+	 * @param p     The Poller that will handle the client's file descriptors.
+	 * @param h     The function to call with each TPV report.
+	 * @param host  The host running gpsd.
+	 * @param port  The port gpsd uses.
+	 * @throw GpsClientResolveError  The host or port could not be resolved.
+	 * @throw TimerFdError           The timer could not be made.
+	 */
+	GpsClient(
+		duds::os::linux::Poller &p,
+		const GpsFixHandler &h,
+		const std::string &host = "localhost",
+		const std::string &port = "2947"
+	);
+	~GpsClient();
+	/**
+	 * True while connected to gpsd.
+	 */
+	virtual bool connected() const {
+		return state == Connected;
+	}
+	/**
+	 * Handles activity on the socket; called by the Poller.
+	 */
+	virtual void respond(duds::os::linux::Poller *, int fd);
+};
+
+#endif        //  #ifndef GPSCLIENT_HPP
@@ -0,0 +1,91 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef GPSFIX_HPP
+#define GPSFIX_HPP
+
+#include "Functions.hpp"
+#include <functional>
+#include <cmath>
+
+/**
+ * A position report from the GPS. Values that were not reported are
+ * not-a-number.
+ * @author  Jeff Jackowski
+ */
+struct GpsFix {
+	/**
+	 * The time of the fix from the GPS in seconds since the Unix epoch.
+	 */
+	double time = NAN;
+	/**
+	 * The time the report was received from the system's real-time clock in
+	 * seconds since the Unix epoch.
+	 */
+	double arrival = NAN;
+	/**
+	 * The location in degrees.
+	 */
+	Location loc = Location(NAN, NAN);
+	/**
+	 * Altitude in meters.
+	 */
+	double altitude = NAN;
+	/**
+	 * East and north position errors as 95% confidence values in meters.
+	 */
+	double epx = NAN, epy = NAN;
+	/**
+	 * Speed over ground in m/s.
+	 */
+	double speed = NAN;
+	/**
+	 * Direction of travel in degrees clockwise from true north.
+	 */
+	double track = NAN;
+	/**
+	 * Speed error as a 95% confidence value in m/s.
+	 */
+	double eps = NAN;
+	/**
+	 * The fix mode as used by gpsd: 0 for unknown, 1 for no fix, 2 for a 2D
+	 * fix, and 3 for a 3D fix.
+	 */
+	int mode = 0;
+	/**
+	 * The fix status as used by gpsd: 0 for no fix, 1 for a normal fix, and
+	 * higher values for augmented fixes.
+	 */
+	int status = 0;
+	/**
+	 * The number of satellites used in the fix.
+	 */
+	int satellites = 0;
+	/**
+	 * True if the report includes a location.
+	 */
+	bool hasLocation() const {
+		return std::isfinite(loc.lon) && std::isfinite(loc.lat);
+	}
+	/**
+	 * True if the report is for a 3D fix using satellites.
+	 */
+	bool good() const {
+		return (status != 0) && (mode == 3) && (satellites > 0);
+	}
+};
+
+/**
+ * Called with each report as it is received.
+ */
+typedef std::function<void(const GpsFix &)>  GpsFixHandler;
+
+#endif        //  #ifndef GPSFIX_HPP
@@ -0,0 +1,374 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "GpsParser.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+/**
+ * Most fields in any parsed NMEA sentence, plus one.
+ */
+static constexpr int maxFields = 24;
+
+static constexpr double metersPerSecPerKnot = 1852.0 / 3600.0;
+
+/**
+ * Standard deviations for a 95% confidence value in one dimension.
+ */
+static constexpr double conf95 = 1.96;
+
+/**
+ * Reads a number from a field; not-a-number if empty.
+ */
+static double number(const char *field) {
+	char *end;
+	double v = std::strtod(field, &end);
+	if (end == field) {
+		return NAN;
+	}
+	return v;
+}
+
+/**
+ * Reads a time of day as hhmmss.ss into seconds; negative if invalid.
+ */
+static double timeOfDay(const char *field) {
+	double t = number(field);
+	if (!std::isfinite(t)) {
+		return -1;
+	}
+	int hms = (int)t;
+	return (hms / 10000) * 3600.0 + ((hms / 100) % 100) * 60.0 +
+		(t - (double)(hms - (hms % 100)));
+}
+
+/**
+ * Reads a latitude or longitude as dddmm.mmmm with its hemisphere.
+ */
+static double angle(const char *field, const char *hemi) {
+	double v = number(field);
+	if (!std::isfinite(v)) {
+		return NAN;
+	}
+	double deg = std::floor(v / 100.0);
+	deg += (v - deg * 100.0) / 60.0;
+	if ((*hemi == 'S') || (*hemi == 'W')) {
+		return -deg;
+	}
+	return deg;
+}
+
+static std::uint16_t u2(const std::uint8_t *p) {
+	return p[0] | (p[1] << 8);
+}
+
+static std::uint32_t u4(const std::uint8_t *p) {
+	return (std::uint32_t)p[0] | ((std::uint32_t)p[1] << 8) |
+		((std::uint32_t)p[2] << 16) | ((std::uint32_t)p[3] << 24);
+}
+
+static std::int32_t i4(const std::uint8_t *p) {
+	return (std::int32_t)u4(p);
+}
+
+static int hexDigit(char c) {
+	if ((c >= '0') && (c <= '9')) {
+		return c - '0';
+	} else if ((c >= 'A') && (c <= 'F')) {
+		return c - 'A' + 10;
+	} else if ((c >= 'a') && (c <= 'f')) {
+		return c - 'a' + 10;
+	}
+	return -1;
+}
+
+void GpsParser::reset() {
+	state = Idle;
+	len = 0;
+	fix = GpsFix();
+	rmcTime = ggaTime = -1;
+}
+
+void GpsParser::feed(const char *data, std::size_t size, double arrival) {
+	const std::uint8_t *end = (const std::uint8_t*)data + size;
+	for (const std::uint8_t *b = (const std::uint8_t*)data; b < end; ++b) {
+		switch (state) {
+			case UbxSync:
+				if (*b == 0x62) {
+					state = Ubx;
+					len = 0;
+					break;
+				}
+				state = Idle;
+				[[fallthrough]];
+			case Idle:
+				if (*b == '$') {
+					state = Nmea;
+					msg[0] = '$';
+					len = 1;
+					msgArrival = arrival;
+				} else if (*b == 0xB5) {
+					state = UbxSync;
+					msgArrival = arrival;
+				}
+				break;
+			case Nmea:
+				if ((*b == '\r') || (*b == '\n')) {
+					msg[len] = 0;
+					sentence();
+					state = Idle;
+				} else if (*b == '$') {
+					// previous sentence cut short
+					++counts.bad;
+					len = 1;
+					msgArrival = arrival;
+				} else if ((*b < 0x20) || (*b > 0x7E)) {
+					// Not NMEA; likely a '$' inside UBX data. Drop the
+					// sentence, but the byte may start a UBX message.
+					++counts.bad;
+					state = Idle;
+					if (*b == 0xB5) {
+						state = UbxSync;
+						msgArrival = arrival;
+					}
+				} else if (len < (sizeof(msg) - 1)) {
+					msg[len++] = *b;
+				} else {
+					++counts.bad;
+					state = Idle;
+				}
+				break;
+			case Ubx:
+				// class, id, 2 byte length, payload, 2 byte checksum
+				msg[len] = *b;
+				if (++len == 4) {
+					ubxLen = u2(msg + 2);
+					// Messages too long to keep are not needed. The sync bytes
+					// also show up in NMEA and other binary data, so this
+					// avoids skipping up to 64K of good data after a false
+					// sync; the checksum rejects the rest.
+					if ((ubxLen + 6) > sizeof(msg)) {
+						state = Idle;
+					}
+				} else if ((len > 4) && (len == (ubxLen + 6))) {
+					ubx();
+					state = Idle;
+				}
+				break;
+		}
+	}
+}
+
+void GpsParser::sentence() {
+	char *text = (char*)msg;
+	char *star = std::strchr(text, '*');
+	if (!star || (hexDigit(star[1]) < 0) || (hexDigit(star[2]) < 0)) {
+		++counts.bad;
+		return;
+	}
+	std::uint8_t sum = 0;
+	for (char *c = text + 1; c < star; ++c) {
+		sum ^= *c;
+	}
+	if (sum != ((hexDigit(star[1]) << 4) | hexDigit(star[2]))) {
+		++counts.bad;
+		return;
+	}
+	++counts.sentences;
+	*star = 0;
+	// split the fields in place
+	char *fields[maxFields];
+	int count = 0;
+	fields[count++] = text;
+	for (char *c = text; *c && (count < maxFields); ++c) {
+		if (*c == ',') {
+			*c = 0;
+			fields[count++] = c + 1;
+		}
+	}
+	// skip "$" and the talker ID; proprietary sentences are ignored
+	if ((std::strlen(fields[0]) != 6) || (text[1] == 'P')) {
+		return;
+	}
+	const char *type = fields[0] + 3;
+	if (std::strcmp(type, "RMC") == 0) {
+		rmc(fields, count);
+	} else if (std::strcmp(type, "GGA") == 0) {
+		gga(fields, count);
+	} else if (std::strcmp(type, "GST") == 0) {
+		gst(fields, count);
+	}
+}
+
+void GpsParser::epoch(double time) {
+	if (
+		((rmcTime >= 0) && (rmcTime != time)) ||
+		((ggaTime >= 0) && (ggaTime != time))
+	) {
+		// an incomplete epoch; drop it
+		fix = GpsFix();
+		rmcTime = ggaTime = -1;
+	}
+	if ((rmcTime < 0) && (ggaTime < 0)) {
+		epochArrival = msgArrival;
+	}
+}
+
+void GpsParser::rmc(char **fields, int count) {
+	if (count < 10) {
+		return;
+	}
+	double time = timeOfDay(fields[1]);
+	if (time < 0) {
+		return;
+	}
+	epoch(time);
+	rmcTime = time;
+	int dmy = std::atoi(fields[9]);
+	if (dmy) {
+		std::tm t = { };
+		t.tm_mday = dmy / 10000;
+		t.tm_mon = (dmy / 100) % 100 - 1;
+		t.tm_year = dmy % 100 + 100;
+		date = (double)timegm(&t);
+	}
+	if (*fields[2] == 'A') {
+		fix.loc = Location(
+			angle(fields[5], fields[6]),
+			angle(fields[3], fields[4])
+		);
+		fix.speed = number(fields[7]) * metersPerSecPerKnot;
+		fix.track = number(fields[8]);
+	}
+	complete();
+}
+
+void GpsParser::gga(char **fields, int count) {
+	if (count < 12) {
+		return;
+	}
+	double time = timeOfDay(fields[1]);
+	if (time < 0) {
+		return;
+	}
+	epoch(time);
+	ggaTime = time;
+	int quality = std::atoi(fields[6]);
+	// map the quality onto gpsd's status values
+	static const int status[9] = { 0, 1, 2, 1, 3, 4, 5, 0, 0 };
+	fix.status = ((quality >= 0) && (quality < 9)) ? status[quality] : 1;
+	fix.satellites = std::atoi(fields[7]);
+	hdop = number(fields[8]);
+	if (quality) {
+		fix.loc = Location(
+			angle(fields[4], fields[5]),
+			angle(fields[2], fields[3])
+		);
+		// height above the ellipsoid, like gpsd's altHAE
+		double sep = number(fields[11]);
+		fix.altitude = number(fields[9]) + (std::isfinite(sep) ? sep : 0.0);
+	}
+	complete();
+}
+
+void GpsParser::gst(char **fields, int count) {
+	if (count < 9) {
+		return;
+	}
+	latSigma = number(fields[6]);
+	lonSigma = number(fields[7]);
+}
+
+void GpsParser::complete() {
+	if ((rmcTime < 0) || (ggaTime != rmcTime)) {
+		return;
+	}
+	if (!useUbx) {
+		fix.time = date + rmcTime;
+		fix.arrival = epochArrival;
+		// GGA gives an altitude only with a 3D fix
+		if (fix.status) {
+			fix.mode = std::isfinite(fix.altitude) ? 3 : 2;
+		} else {
+			fix.mode = 1;
+		}
+		if (std::isfinite(latSigma) && std::isfinite(lonSigma)) {
+			fix.epx = lonSigma * conf95;
+			fix.epy = latSigma * conf95;
+		} else if (std::isfinite(hdop)) {
+			fix.epx = fix.epy = hdop * uere;
+		}
+		++counts.fixes;
+		handler(fix);
+	}
+	fix = GpsFix();
+	rmcTime = ggaTime = -1;
+}
+
+void GpsParser::ubx() {
+	// Fletcher checksum over the class, id, length, and payload
+	std::uint8_t a = 0, b = 0;
+	for (std::size_t i = 0; i < (ubxLen + 4); ++i) {
+		a += msg[i];
+		b += a;
+	}
+	if ((a != msg[ubxLen + 4]) || (b != msg[ubxLen + 5])) {
+		++counts.bad;
+		return;
+	}
+	++counts.ubx;
+	// only NAV-PVT
+	if ((msg[0] != 0x01) || (msg[1] != 0x07) || (ubxLen < 92)) {
+		return;
+	}
+	useUbx = true;
+	const std::uint8_t *p = msg + 4;
+	GpsFix pvt;
+	pvt.arrival = msgArrival;
+	// valid date and time
+	if ((p[11] & 3) == 3) {
+		std::tm t = { };
+		t.tm_year = u2(p + 4) - 1900;
+		t.tm_mon = p[6] - 1;
+		t.tm_mday = p[7];
+		t.tm_hour = p[8];
+		t.tm_min = p[9];
+		t.tm_sec = p[10];
+		pvt.time = (double)timegm(&t) + i4(p + 16) * 1e-9;
+	}
+	switch (p[20]) {
+		case 3:  // 3D
+		case 4:  // GNSS and dead reckoning
+			pvt.mode = 3;
+			break;
+		case 2:
+			pvt.mode = 2;
+			break;
+		default:
+			pvt.mode = 1;
+	}
+	// gnssFixOK and diffSoln flags
+	pvt.status = (p[21] & 1) ? ((p[21] & 2) ? 2 : 1) : 0;
+	pvt.satellites = p[23];
+	if (pvt.mode >= 2) {
+		pvt.loc = Location(i4(p + 24) * 1e-7, i4(p + 28) * 1e-7);
+		pvt.altitude = i4(p + 32) * 1e-3;
+		// hAcc is about one standard deviation of the horizontal distance;
+		// split it between two axes
+		pvt.epx = pvt.epy = u4(p + 40) * 1e-3 * conf95 / std::sqrt(2.0);
+		pvt.speed = i4(p + 60) * 1e-3;
+		pvt.track = i4(p + 64) * 1e-5;
+		pvt.eps = u4(p + 68) * 1e-3 * conf95;
+	}
+	++counts.fixes;
+	handler(pvt);
+}
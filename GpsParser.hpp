@@ -0,0 +1,182 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef GPSPARSER_HPP
+#define GPSPARSER_HPP
+
+#include "GpsFix.hpp"
+#include <cstdint>
+
+/**
+ * Counts of what GpsParser has seen.
+ */
+struct GpsParserStats {
+	/**
+	 * NMEA sentences with a good checksum.
+	 */
+	unsigned long sentences = 0;
+	/**
+	 * UBX messages with a good checksum.
+	 */
+	unsigned long ubx = 0;
+	/**
+	 * Sentences and messages dropped for a bad checksum or length.
+	 */
+	unsigned long bad = 0;
+	/**
+	 * Fixes passed to the handler.
+	 */
+	unsigned long fixes = 0;
+};
+
+/**
+ * An incremental parser for the output of a GPS receiver. Data is given to
+ * feed() in pieces of any size as it is read, and fixes are passed to the
+ * handler as soon as they are complete. No memory is allocated; sentences
+ * are assembled in a fixed buffer and parsed in place.
+ *
+ * NMEA 0183 sentences of any talker are parsed:
+ * - RMC for the date, time, location, speed, and track
+ * - GGA for the location, altitude, fix quality, satellites used, and HDOP
+ * - GST for the position error
+ * A fix is reported once both RMC and GGA for the same time have arrived.
+ * The fix mode comes from the GGA's quality and altitude. GSA is not used
+ * because it has no time and usually follows the GGA, so it would only
+ * apply to the next epoch.
+ * The position error comes from the latest GST if the receiver sends it,
+ * or else is estimated from the HDOP.
+ *
+ * u-blox UBX messages may be mixed in with the NMEA sentences. Only
+ * NAV-PVT is parsed; it holds everything in a fix, so each one is reported
+ * immediately. Once a NAV-PVT has been seen, the NMEA sentences no longer
+ * produce fixes so that each epoch is not reported twice.
+ * @author  Jeff Jackowski
+ */
+class GpsParser {
+	GpsFixHandler handler;
+	/**
+	 * The fix being assembled from NMEA sentences.
+	 */
+	GpsFix fix;
+	/**
+	 * The message being received. Big enough for the largest NMEA sentence
+	 * and a NAV-PVT message.
+	 */
+	std::uint8_t msg[128];
+	/**
+	 * Bytes received for the current message.
+	 */
+	std::size_t len = 0;
+	/**
+	 * The length of the current UBX message's payload.
+	 */
+	std::size_t ubxLen;
+	/**
+	 * Arrival time of the first byte of the current message.
+	 */
+	double msgArrival;
+	/**
+	 * Arrival time of the first sentence of the epoch being assembled.
+	 */
+	double epochArrival;
+	/**
+	 * Time of day in seconds of the RMC and GGA sentences in @a fix, or
+	 * negative if not yet seen for this epoch.
+	 */
+	double rmcTime = -1, ggaTime = -1;
+	/**
+	 * The date from the last RMC as seconds since the Unix epoch at midnight.
+	 */
+	double date = NAN;
+	/**
+	 * Horizontal dilution of precision from the GGA of the current epoch.
+	 */
+	double hdop = NAN;
+	/**
+	 * Standard deviations of the latitude and longitude errors in meters
+	 * from the last GST.
+	 */
+	double latSigma = NAN, lonSigma = NAN;
+	enum State {
+		/**
+		 * Looking for the start of a message.
+		 */
+		Idle,
+		/**
+		 * Receiving an NMEA sentence.
+		 */
+		Nmea,
+		/**
+		 * Received the first UBX sync byte.
+		 */
+		UbxSync,
+		/**
+		 * Receiving a UBX message.
+		 */
+		Ubx
+	};
+	State state = Idle;
+	/**
+	 * True once a NAV-PVT message has been received.
+	 */
+	bool useUbx = false;
+	GpsParserStats counts;
+	/**
+	 * Handles a complete NMEA sentence in @a msg.
+	 */
+	void sentence();
+	/**
+	 * Handles a complete UBX message in @a msg.
+	 */
+	void ubx();
+	void rmc(char **fields, int count);
+	void gga(char **fields, int count);
+	void gst(char **fields, int count);
+	/**
+	 * Reports the fix if both RMC and GGA for the same time are in.
+	 */
+	void complete();
+	/**
+	 * Starts assembling a new epoch if @a time differs from the current one.
+	 */
+	void epoch(double time);
+public:
+	/**
+	 * Estimated 95% confidence position error, in meters per unit of HDOP,
+	 * used when the receiver does not send GST sentences.
+	 */
+	static constexpr double uere = 5.0;
+	/**
+	 * Makes a parser that will call the given handler with each fix.
+	 */
+	GpsParser(const GpsFixHandler &h) : handler(h) { }
+	/**
+	 * Parses received data.
+	 * @param data     The data; need not contain whole messages.
+	 * @param size     The number of bytes in @a data.
+	 * @param arrival  The time the data arrived in seconds since the Unix
+	 *                 epoch.
+	 */
+	void feed(const char *data, std::size_t size, double arrival);
+	/**
+	 * Forgets any partial message and the fix being assembled, as after
+	 * reopening the device.
+	 */
+	void reset();
+	/**
+	 * Returns counts of what has been parsed.
+	 */
+	const GpsParserStats &stats() const {
+		return counts;
+	}
+};
+
+#endif        //  #ifndef GPSPARSER_HPP
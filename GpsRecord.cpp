@@ -0,0 +1,116 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "GpsRecord.hpp"
+#include <boost/exception/errinfo_file_name.hpp>
+#include <boost/throw_exception.hpp>
+#include <cstring>
+
+/**
+ * Identifies the file format and its version.
+ */
+static const char magic[8] = { 'E', 'C', 'L', 'G', 'P', 'S', '0', '1' };
+
+namespace {
+
+/**
+ * Copies values into or out of a record in order.
+ */
+class Packer {
+	char *pos;
+public:
+	Packer(char *p) : pos(p) { }
+	template <class T>
+	void put(T v) {
+		std::memcpy(pos, &v, sizeof(T));
+		pos += sizeof(T);
+	}
+	template <class T>
+	T get() {
+		T v;
+		std::memcpy(&v, pos, sizeof(T));
+		pos += sizeof(T);
+		return v;
+	}
+};
+
+}
+
+GpsRecorder::GpsRecorder(const std::string &path) :
+out(path, std::ios::binary | std::ios::trunc) {
+	if (!out) {
+		BOOST_THROW_EXCEPTION(GpsRecordOpenError() <<
+			boost::errinfo_file_name(path)
+		);
+	}
+	out.write(magic, sizeof(magic));
+}
+
+void GpsRecorder::record(const GpsFix &fix) {
+	char rec[GpsRecordSize];
+	Packer p(rec);
+	p.put(fix.arrival);
+	p.put(fix.time);
+	p.put(fix.loc.lon);
+	p.put(fix.loc.lat);
+	p.put((float)fix.altitude);
+	p.put((float)fix.epx);
+	p.put((float)fix.epy);
+	p.put((float)fix.speed);
+	p.put((float)fix.track);
+	p.put((float)fix.eps);
+	p.put((std::int8_t)fix.mode);
+	p.put((std::int8_t)fix.status);
+	p.put((std::uint8_t)fix.satellites);
+	p.put((std::uint8_t)0);
+	out.write(rec, sizeof(rec));
+	out.flush();
+}
+
+GpsRecordReader::GpsRecordReader(const std::string &path) :
+in(path, std::ios::binary) {
+	if (!in) {
+		BOOST_THROW_EXCEPTION(GpsRecordOpenError() <<
+			boost::errinfo_file_name(path)
+		);
+	}
+	char id[sizeof(magic)];
+	if (
+		!in.read(id, sizeof(id)) ||
+		(std::memcmp(id, magic, sizeof(magic)) != 0)
+	) {
+		BOOST_THROW_EXCEPTION(GpsRecordBadFormat() <<
+			boost::errinfo_file_name(path)
+		);
+	}
+}
+
+bool GpsRecordReader::next(GpsFix &fix) {
+	char rec[GpsRecordSize];
+	if (!in.read(rec, sizeof(rec))) {
+		return false;
+	}
+	Packer p(rec);
+	fix.arrival = p.get<double>();
+	fix.time = p.get<double>();
+	fix.loc.lon = p.get<double>();
+	fix.loc.lat = p.get<double>();
+	fix.altitude = p.get<float>();
+	fix.epx = p.get<float>();
+	fix.epy = p.get<float>();
+	fix.speed = p.get<float>();
+	fix.track = p.get<float>();
+	fix.eps = p.get<float>();
+	fix.mode = p.get<std::int8_t>();
+	fix.status = p.get<std::int8_t>();
+	fix.satellites = p.get<std::uint8_t>();
+	return true;
+}
@@ -0,0 +1,82 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef GPSRECORD_HPP
+#define GPSRECORD_HPP
+
+#include <boost/exception/info.hpp>
+#include <boost/noncopyable.hpp>
+#include "GpsFix.hpp"
+#include <fstream>
+#include <string>
+
+struct GpsRecordError : virtual std::exception, virtual boost::exception { };
+/**
+ * The file could not be opened.
+ */
+struct GpsRecordOpenError : GpsRecordError { };
+/**
+ * The file is not a GPS recording.
+ */
+struct GpsRecordBadFormat : GpsRecordError { };
+
+/**
+ * Size of one fix in a recording file.
+ */
+constexpr std::size_t GpsRecordSize = 60;
+
+/**
+ * Writes every GPS report to a compact binary file for later replay. The
+ * file starts with an 8 byte identifier, followed by one fixed size record
+ * per report. Each record holds the arrival and fix times, location, and
+ * altitude as doubles; the errors, speed, and track as floats; and the
+ * mode, status, and satellite count as bytes. All values use the host's
+ * byte order, which is little endian on all the intended hardware.
+ *
+ * The file is flushed after each record so that little is lost if the
+ * program stops abruptly.
+ * @author  Jeff Jackowski
+ */
+class GpsRecorder : boost::noncopyable {
+	std::ofstream out;
+public:
+	/**
+	 * Creates the file, replacing any existing file.
+	 * @throw GpsRecordOpenError  The file could not be created.
+	 */
+	GpsRecorder(const std::string &path);
+	/**
+	 * Appends a report to the file.
+	 */
+	void record(const GpsFix &fix);
+};
+
+/**
+ * Reads the reports from a file made by GpsRecorder.
+ * @author  Jeff Jackowski
+ */
+class GpsRecordReader : boost::noncopyable {
+	std::ifstream in;
+public:
+	/**
+	 * Opens the file and checks its identifier.
+	 * @throw GpsRecordOpenError  The file could not be opened.
+	 * @throw GpsRecordBadFormat  The file is not a GPS recording.
+	 */
+	GpsRecordReader(const std::string &path);
+	/**
+	 * Reads the next report.
+	 * @return  False at the end of the file.
+	 */
+	bool next(GpsFix &fix);
+};
+
+#endif        //  #ifndef GPSRECORD_HPP
@@ -0,0 +1,57 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "GpsReplay.hpp"
+
+GpsReplay::GpsReplay(
+	duds::os::linux::Poller &p,
+	const GpsFixHandler &h,
+	const std::string &path,
+	double s
+) : handler(h), reader(path), speed(s),
+timer(p, std::bind(&GpsReplay::play, this)) {
+	more = reader.next(next);
+	first = next.arrival;
+	start = Clock::now();
+	schedule();
+}
+
+void GpsReplay::schedule() {
+	if (!more) {
+		return;
+	}
+	if (speed > 0) {
+		auto due = start + std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double>((next.arrival - first) / speed)
+		);
+		timer.once(due - Clock::now());
+	} else {
+		// as soon as possible, after other waiting work
+		timer.once(std::chrono::nanoseconds(0));
+	}
+}
+
+void GpsReplay::play() {
+	double elapsed = std::chrono::duration<double>(
+		Clock::now() - start
+	).count();
+	for (
+		int limit = batch;
+		more && limit &&
+		((speed <= 0) || (((next.arrival - first) / speed) <= elapsed));
+		--limit
+	) {
+		handler(next);
+		++count;
+		more = reader.next(next);
+	}
+	schedule();
+}
@@ -0,0 +1,107 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef GPSREPLAY_HPP
+#define GPSREPLAY_HPP
+
+#include "GpsRecord.hpp"
+#include "GpsSource.hpp"
+#include "TimerFd.hpp"
+#include <chrono>
+
+/**
+ * Plays back a file made by GpsRecorder as a GpsSource, so the recorded
+ * reports go through the same handling as live ones. The reports keep
+ * their original spacing, divided by a speed factor, or are played as fast
+ * as possible. A TimerFd registered with a Poller paces the playback.
+ *
+ * The reports are passed on unchanged, including their recorded times.
+ * @author  Jeff Jackowski
+ */
+class GpsReplay : public GpsSource {
+	typedef std::chrono::steady_clock Clock;
+	GpsFixHandler handler;
+	GpsRecordReader reader;
+	/**
+	 * The next report to play.
+	 */
+	GpsFix next;
+	/**
+	 * When playback started.
+	 */
+	Clock::time_point start;
+	/**
+	 * Arrival time of the first report.
+	 */
+	double first;
+	double speed;
+	TimerFd timer;
+	/**
+	 * Number of reports played.
+	 */
+	unsigned long count = 0;
+	bool more;
+	/**
+	 * Arms the timer for the next report.
+	 */
+	void schedule();
+	/**
+	 * Plays the reports that are due.
+	 */
+	void play();
+public:
+	/**
+	 * Most reports played at once when going as fast as possible, so that
+	 * other work waiting on the Poller is not starved.
+	 */
+	static constexpr int batch = 64;
+	/**
+	 * Opens the file and starts playback.
+	 * @param p      The Poller that will handle the timer.
+	 * @param h      The function to call with each report.
+	 * @param path   The recording.
+	 * @param speed  The speed factor; 1 for real time, 10 for ten times
+	 *               faster, or zero for as fast as possible.
+	 * @throw GpsRecordOpenError  The file could not be opened.
+	 * @throw GpsRecordBadFormat  The file is not a GPS recording.
+	 * @throw TimerFdError        The timer could not be made.
+	 */
+	GpsReplay(
+		duds::os::linux::Poller &p,
+		const GpsFixHandler &h,
+		const std::string &path,
+		double speed = 1.0
+	);
+	/**
+	 * True until the end of the recording.
+	 */
+	virtual bool connected() const {
+		return more;
+	}
+	/**
+	 * True once all the reports have been played.
+	 */
+	bool finished() const {
+		return !more;
+	}
+	/**
+	 * The number of reports played so far.
+	 */
+	unsigned long played() const {
+		return count;
+	}
+	/**
+	 * Does nothing; the timer plays the reports.
+	 */
+	virtual void respond(duds::os::linux::Poller *, int) { }
+};
+
+#endif        //  #ifndef GPSREPLAY_HPP
@@ -0,0 +1,36 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef GPSSOURCE_HPP
+#define GPSSOURCE_HPP
+
+#include <duds/os/linux/Poller.hpp>
+#include <boost/noncopyable.hpp>
+#include "GpsFix.hpp"
+
+/**
+ * Something that provides GPS reports by responding to events from a Poller.
+ * Each report is passed to a GpsFixHandler as it is parsed.
+ * @author  Jeff Jackowski
+ */
+class GpsSource :
+	public duds::os::linux::PollResponder,
+	boost::noncopyable
+{
+public:
+	virtual ~GpsSource() = default;
+	/**
+	 * True while the source is able to provide reports.
+	 */
+	virtual bool connected() const = 0;
+};
+
+#endif        //  #ifndef GPSSOURCE_HPP
@@ -0,0 +1,220 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "Horizon.hpp"
+#include <boost/exception/errinfo_file_name.hpp>
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <cmath>
+
+/**
+ * Meters per degree of latitude.
+ */
+static constexpr double metersPerDegree = 111195.0;
+
+/**
+ * Earth radius in meters, less the effect of atmospheric refraction, for
+ * finding how far distant terrain drops below the horizontal.
+ */
+static constexpr double refractedRadius = 6371000.0 / (1.0 - 0.13);
+
+struct Horizon::Window {
+	/**
+	 * Elevations in meters; NaN where the DEM has no data.
+	 */
+	const float *elev;
+	/**
+	 * Size of the window in pixels.
+	 */
+	int width, height;
+	/**
+	 * Observer position within the window in pixels.
+	 */
+	double x, y;
+	/**
+	 * Meters per pixel.
+	 */
+	double dx, dy;
+	/**
+	 * Height of the observer's eyes in meters.
+	 */
+	double height0;
+	/**
+	 * Distance between samples along a ray in meters.
+	 */
+	double step;
+	/**
+	 * Returns the elevation at a position in pixels using bilinear
+	 * interpolation, or NaN if outside the window.
+	 */
+	double sample(double px, double py) const {
+		int ix = (int)std::floor(px);
+		int iy = (int)std::floor(py);
+		if ((ix < 0) || (iy < 0) || (ix >= (width - 1)) || (iy >= (height - 1))) {
+			return NAN;
+		}
+		double fx = px - (double)ix;
+		double fy = py - (double)iy;
+		const float *row = elev + iy * width + ix;
+		return (row[0] * (1.0 - fx) + row[1] * fx) * (1.0 - fy) +
+			(row[width] * (1.0 - fx) + row[width + 1] * fx) * fy;
+	}
+};
+
+Horizon::Horizon(const std::string &path) {
+	dataset = GDALDatasetUPtr((GDALDataset*)GDALOpenEx(
+		path.c_str(), GDAL_OF_RASTER, nullptr, nullptr, nullptr
+	), GDALDatasetDeleter());
+	if (!dataset) {
+		BOOST_THROW_EXCEPTION(HorizonOpenError() <<
+			boost::errinfo_file_name(path)
+		);
+	}
+	if (dataset->GetRasterCount() < 1) {
+		BOOST_THROW_EXCEPTION(HorizonNoBand() <<
+			boost::errinfo_file_name(path)
+		);
+	}
+	band = dataset->GetRasterBand(1);
+	// must be north-up with no rotation
+	if (
+		(dataset->GetGeoTransform(xform) != CE_None) ||
+		(xform[2] != 0) || (xform[4] != 0) || (xform[5] >= 0)
+	) {
+		BOOST_THROW_EXCEPTION(HorizonNoTransform() <<
+			boost::errinfo_file_name(path)
+		);
+	}
+	int success = 0;
+	nodata = band->GetNoDataValue(&success);
+	hasNodata = success != 0;
+	profile.fill(0);
+}
+
+void Horizon::trace(float *angles, const Window &w, int first, int last) const {
+	for (int b = first; b < last; ++b) {
+		// ray through the middle of the bin
+		double az = ((double)b + 0.5) * M_PI / 180.0;
+		double east = std::sin(az);
+		double north = std::cos(az);
+		double best = -90.0;
+		for (double d = w.step; d < range; d += w.step) {
+			double h = w.sample(w.x + east * d / w.dx, w.y - north * d / w.dy);
+			if (std::isnan(h)) {
+				continue;
+			}
+			double drop = d * d / (2.0 * refractedRadius);
+			best = std::max(best, std::atan2(h - drop - w.height0, d));
+		}
+		// nothing found means no terrain data; call it flat
+		angles[b] = (best == -90.0) ? 0.0f : (float)(best * 180.0 / M_PI);
+	}
+}
+
+bool Horizon::update(const Location &l) {
+	{
+		std::lock_guard<duds::general::Spinlock> lock(block);
+		if (valid && (haversineEarth(loc, l) < threshold)) {
+			return false;
+		}
+	}
+	Window w;
+	w.dx = std::fabs(xform[1]) * metersPerDegree * std::cos(l.lat * M_PI / 180.0);
+	w.dy = std::fabs(xform[5]) * metersPerDegree;
+	w.step = std::min(w.dx, w.dy);
+	// observer in pixels
+	double px = (l.lon - xform[0]) / xform[1];
+	double py = (l.lat - xform[3]) / xform[5];
+	int xsize = dataset->GetRasterXSize();
+	int ysize = dataset->GetRasterYSize();
+	if ((px < 0) || (py < 0) || (px >= xsize) || (py >= ysize)) {
+		std::lock_guard<duds::general::Spinlock> lock(block);
+		valid = false;
+		return false;
+	}
+	// the geotransform gives the corners of pixels, but sample() has the
+	// pixels' values at whole numbers, so move to the pixel centers
+	px -= 0.5;
+	py -= 0.5;
+	// read only the part of the DEM within range
+	int x0 = std::max(0, (int)(px - range / w.dx) - 1);
+	int y0 = std::max(0, (int)(py - range / w.dy) - 1);
+	int x1 = std::min(xsize, (int)(px + range / w.dx) + 2);
+	int y1 = std::min(ysize, (int)(py + range / w.dy) + 2);
+	w.width = x1 - x0;
+	w.height = y1 - y0;
+	window.resize((std::size_t)w.width * (std::size_t)w.height);
+	if (band->RasterIO(
+		GF_Read, x0, y0, w.width, w.height, window.data(), w.width, w.height,
+		GDT_Float32, 0, 0
+	) != CE_None) {
+		std::lock_guard<duds::general::Spinlock> lock(block);
+		valid = false;
+		return false;
+	}
+	if (hasNodata) {
+		float nd = (float)nodata;
+		std::replace(window.begin(), window.end(), nd, (float)NAN);
+	}
+	w.elev = window.data();
+	w.x = px - (double)x0;
+	w.y = py - (double)y0;
+	w.height0 = w.sample(w.x, w.y);
+	if (std::isnan(w.height0)) {
+		std::lock_guard<duds::general::Spinlock> lock(block);
+		valid = false;
+		return false;
+	}
+	w.height0 += eyeHeight;
+	// split the bins among threads
+	std::array<float, bins> angles;
+	int threads = std::clamp((int)std::thread::hardware_concurrency(), 1, 8);
+	std::vector<std::future<void>> work;
+	for (int t = 1; t < threads; ++t) {
+		work.emplace_back(std::async(
+			std::launch::async,
+			&Horizon::trace,
+			this,
+			angles.data(),
+			std::cref(w),
+			bins * t / threads,
+			bins * (t + 1) / threads
+		));
+	}
+	// this thread does its share, too
+	trace(angles.data(), w, 0, bins / threads);
+	for (std::future<void> &f : work) {
+		f.get();
+	}
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	profile = angles;
+	loc = l;
+	valid = true;
+	return true;
+}
+
+bool Horizon::good() const {
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	return valid;
+}
+
+double Horizon::angle(double azimuth) const {
+	int b = (int)std::floor(azimuth) % bins;
+	if (b < 0) {
+		b += bins;
+	}
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	if (!valid) {
+		return 0;
+	}
+	return profile[b];
+}
@@ -0,0 +1,128 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef HORIZON_HPP
+#define HORIZON_HPP
+
+#include <gdal/gdal_priv.h>
+#include <duds/general/Spinlock.hpp>
+#include "Umbra.hpp"
+#include <array>
+#include <vector>
+
+struct HorizonError : virtual std::exception, virtual boost::exception { };
+struct HorizonOpenError : HorizonError { };
+struct HorizonNoBand : HorizonError { };
+struct HorizonNoTransform : HorizonError { };
+
+/**
+ * The angle of the terrain above the horizontal in all directions from one
+ * location, found from a digital elevation model (DEM). The DEM is read with
+ * GDAL, so any raster format it supports will do, but it must use longitude
+ * and latitude for its coordinates and meters for its elevation, like the
+ * USGS 1 arc-second GeoTIFF files.
+ *
+ * The profile is computed by update() when the location changes by more than
+ * @a threshold. The azimuth bins are split among several threads. Afterwards,
+ * lookups are just an array index, and may be done from any thread.
+ * @author  Jeff Jackowski
+ */
+class Horizon : boost::noncopyable {
+public:
+	/**
+	 * Number of azimuth bins; each covers one degree.
+	 */
+	static constexpr int bins = 360;
+	/**
+	 * Distance in meters of the farthest terrain considered.
+	 */
+	static constexpr double range = 20000.0;
+	/**
+	 * Distance in meters the location must move to recompute the profile.
+	 */
+	static constexpr double threshold = 100.0;
+	/**
+	 * Height of the observer's eyes, or sun-watching equipment, above the
+	 * ground in meters.
+	 */
+	static constexpr double eyeHeight = 1.5;
+private:
+	GDALDatasetUPtr dataset;
+	GDALRasterBand *band;
+	/**
+	 * DEM samples around the location; kept to avoid reallocating.
+	 */
+	std::vector<float> window;
+	/**
+	 * The GDAL geotransform for the DEM.
+	 */
+	double xform[6];
+	double nodata;
+	/**
+	 * The terrain angle in degrees for each bin.
+	 */
+	std::array<float, bins> profile;
+	/**
+	 * Location of the current profile.
+	 */
+	Location loc;
+	/**
+	 * Protects @a profile, @a loc, and @a valid.
+	 */
+	mutable duds::general::Spinlock block;
+	bool hasNodata;
+	bool valid = false;
+	/**
+	 * Values needed to trace rays across the DEM window.
+	 */
+	struct Window;
+	/**
+	 * Computes the terrain angle for bins [@a first, @a last).
+	 */
+	void trace(float *angles, const Window &w, int first, int last) const;
+public:
+	/**
+	 * Opens the DEM. GDALAllRegister() must be called first, and not
+	 * concurrently with this.
+	 * @throw HorizonOpenError    The file could not be opened as a raster.
+	 * @throw HorizonNoBand       The file has no raster bands.
+	 * @throw HorizonNoTransform  The file lacks geographic coordinates.
+	 */
+	Horizon(const std::string &path);
+	/**
+	 * Recomputes the profile if the location moved more than @a threshold
+	 * since the last computation. Only one thread may call this function at a
+	 * time.
+	 * @return  True if the profile was recomputed. If the location is outside
+	 *          the DEM, the profile is invalidated and false is returned.
+	 */
+	bool update(const Location &l);
+	/**
+	 * True if there is a profile for the current location.
+	 */
+	bool good() const;
+	/**
+	 * Returns the angle of the terrain in degrees above horizontal in the
+	 * given direction. Returns zero if the profile is not valid.
+	 * @param azimuth  Degrees clockwise from north.
+	 */
+	double angle(double azimuth) const;
+	/**
+	 * Returns the degrees the sun clears the terrain; negative when blocked.
+	 * @param azimuth    The sun's azimuth in degrees.
+	 * @param elevation  The sun's elevation in degrees.
+	 */
+	double clearance(double azimuth, double elevation) const {
+		return elevation - angle(azimuth);
+	}
+};
+
+#endif        //  #ifndef HORIZON_HPP
@@ -0,0 +1,131 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "I2cSensors.hpp"
+#include <duds/hardware/interface/linux/DevSmbus.hpp>
+#include <duds/hardware/interface/linux/DevI2c.hpp>
+
+Ina219Sensor::Ina219Sensor(const std::string &i2cpath, DisplayStuff &dstuff) :
+SensorDevice("INA219", std::chrono::seconds(2)), path(i2cpath), ds(dstuff) { }
+
+void Ina219Sensor::open() {
+	std::unique_ptr<duds::hardware::interface::Smbus> smbus(
+		new duds::hardware::interface::linux::DevSmbus(
+			path,
+			0x40,
+			duds::hardware::interface::Smbus::NoPec()
+		)
+	);
+	dev = std::make_unique<duds::hardware::devices::instruments::INA219>(
+		smbus, 0.1
+	);
+}
+
+void Ina219Sensor::sample(bool first) {
+	dev->sample();
+	if (first) {
+		// intialize exponential moving average for battery
+		ds.initBatteryData(dev->busVoltage(), dev->busPower());
+	} else {
+		ds.setBatteryData(dev->busVoltage(), dev->busPower());
+	}
+}
+
+void Ina219Sensor::close() {
+	dev.reset();
+}
+
+Am2320Sensor::Am2320Sensor(const std::string &i2cpath, DisplayStuff &dstuff) :
+SensorDevice("AM2320", std::chrono::seconds(2), 8), path(i2cpath),
+ds(dstuff) { }
+
+void Am2320Sensor::open() {
+	std::unique_ptr<duds::hardware::interface::I2c> i2c(
+		new duds::hardware::interface::linux::DevI2c(path, 0x5C)
+	);
+	dev = std::make_unique<duds::hardware::devices::instruments::AM2320>(
+		i2c
+	);
+}
+
+void Am2320Sensor::sample(bool first) {
+	dev->sample();
+	if (first) {
+		// intialize exponential moving average for temperature & humidity
+		ds.initTempData(dev->temperature(), dev->relHumidity());
+	} else {
+		ds.setTempData(dev->temperature(), dev->relHumidity());
+	}
+}
+
+void Am2320Sensor::close() {
+	dev.reset();
+}
+
+Tsl2591Sensor::Tsl2591Sensor(
+	const std::string &i2cpath,
+	duds::hardware::interface::linux::SysPwm &pwmout
+) : SensorDevice("TSL2591", std::chrono::seconds(1)), path(i2cpath),
+pwm(pwmout) { }
+
+void Tsl2591Sensor::open() {
+	std::unique_ptr<duds::hardware::interface::I2c> i2c(
+		new duds::hardware::interface::linux::DevI2c(path, 0x29)
+	);
+	dev = std::make_unique<duds::hardware::devices::instruments::TSL2591>(
+		i2c
+	);
+	dev->init(0, 0);
+}
+
+void Tsl2591Sensor::sample(bool first) {
+	dev->sample();
+	if (first) {
+		brightness = (double)dev->brightnessCount();
+	} else {
+		brightness = brightness * 0.8 +
+			0.2 * (double)dev->brightnessCount();
+	}
+	// plenty bright?
+	if (brightness > 11000.0) {
+		// no need of backlight
+		pwm.disable();
+	}
+	// somewhat bright
+	else if (brightness > 8777.0) {
+		// max backlight
+		pwm.dutyFull();
+		pwm.enable();
+	}
+	// dim
+	else {
+		// minimum backlight out of 10% at 1000 (not really) and below.
+		/**
+		 * @bug  If an exception is thrown in the next line, the
+		 *       process will abort even though this is inside
+		 *       a try-catch block that should catch any exception
+		 *       type.
+		 */
+		pwm.dutyCycle(std::max((brightness - 1000.0) / (7000.0 / 0.9), 0.08));
+		pwm.enable();
+	}
+}
+
+void Tsl2591Sensor::close() {
+	dev.reset();
+}
+
+void Tsl2591Sensor::failed() {
+	try {
+		pwm.dutyCycle(0.4);
+		pwm.enable();
+	} catch (...) { }
+}
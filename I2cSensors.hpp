@@ -0,0 +1,93 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef I2CSENSORS_HPP
+#define I2CSENSORS_HPP
+
+#include <duds/hardware/devices/instruments/AM2320.hpp>
+#include <duds/hardware/devices/instruments/INA219.hpp>
+#include <duds/hardware/devices/instruments/TSL2591.hpp>
+#include <duds/hardware/interface/linux/SysPwm.hpp>
+#include "DisplayStuff.hpp"
+#include "SensorWorker.hpp"
+
+/**
+ * The INA219 measuring the battery's voltage and power.
+ * @author  Jeff Jackowski
+ */
+class Ina219Sensor : public SensorDevice {
+	std::string path;
+	DisplayStuff &ds;
+	std::unique_ptr<duds::hardware::devices::instruments::INA219> dev;
+protected:
+	virtual void open();
+	virtual void sample(bool first);
+	virtual void close();
+public:
+	/**
+	 * @param i2cpath  The path to the I2C bus device file.
+	 * @param dstuff   Gets the measurements.
+	 */
+	Ina219Sensor(const std::string &i2cpath, DisplayStuff &dstuff);
+};
+
+/**
+ * The AM2320 measuring temperature and relative humidity. It sleeps between
+ * uses and often fails to respond to the first attempt to wake it, so it is
+ * allowed more failures in a row than the others.
+ * @author  Jeff Jackowski
+ */
+class Am2320Sensor : public SensorDevice {
+	std::string path;
+	DisplayStuff &ds;
+	std::unique_ptr<duds::hardware::devices::instruments::AM2320> dev;
+protected:
+	virtual void open();
+	virtual void sample(bool first);
+	virtual void close();
+public:
+	/**
+	 * @param i2cpath  The path to the I2C bus device file.
+	 * @param dstuff   Gets the measurements.
+	 */
+	Am2320Sensor(const std::string &i2cpath, DisplayStuff &dstuff);
+};
+
+/**
+ * The TSL2591 measuring ambient light to control the display's backlight.
+ * If the sensor fails, the backlight is left on at a moderate level.
+ * @author  Jeff Jackowski
+ */
+class Tsl2591Sensor : public SensorDevice {
+	std::string path;
+	duds::hardware::interface::linux::SysPwm &pwm;
+	std::unique_ptr<duds::hardware::devices::instruments::TSL2591> dev;
+	/**
+	 * Moving average of the brightness count.
+	 */
+	double brightness = 0;
+protected:
+	virtual void open();
+	virtual void sample(bool first);
+	virtual void close();
+	virtual void failed();
+public:
+	/**
+	 * @param i2cpath  The path to the I2C bus device file.
+	 * @param pwmout   The PWM output controlling the backlight.
+	 */
+	Tsl2591Sensor(
+		const std::string &i2cpath,
+		duds::hardware::interface::linux::SysPwm &pwmout
+	);
+};
+
+#endif        //  #ifndef I2CSENSORS_HPP
@@ -0,0 +1,140 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "Metrics.hpp"
+
+EclipseMetrics metrics;
+
+Metric::Metric(MetricRegistry &reg, const char *name, const char *help) :
+nm(name), hlp(help) {
+	reg.add(this);
+}
+
+/**
+ * Writes the HELP and TYPE lines that start each metric.
+ */
+static void writeHeader(
+	std::ostream &os,
+	const char *name,
+	const char *help,
+	const char *type
+) {
+	os << "# HELP " << name << ' ' << help << "\n# TYPE " << name << ' ' <<
+	type << '\n';
+}
+
+void MetricCounter::write(std::ostream &os) const {
+	writeHeader(os, name(), help(), "counter");
+	os << name() << ' ' << get() << '\n';
+}
+
+MetricHistogram::MetricHistogram(
+	MetricRegistry &reg,
+	const char *name,
+	const char *help,
+	std::initializer_list<double> bnds
+) : Metric(reg, name, help), bounds(bnds),
+buckets(new std::atomic<std::uint64_t>[bnds.size() + 1]), total(0), sum(0),
+most(0) {
+	for (std::size_t b = 0; b <= bounds.size(); ++b) {
+		buckets[b].store(0, std::memory_order_relaxed);
+	}
+}
+
+void MetricHistogram::observe(std::chrono::nanoseconds t) {
+	std::uint64_t ns = (t.count() > 0) ? (std::uint64_t)t.count() : 0;
+	double s = (double)ns / 1e9;
+	std::size_t b = 0;
+	while ((b < bounds.size()) && (s > bounds[b])) {
+		++b;
+	}
+	buckets[b].fetch_add(1, std::memory_order_relaxed);
+	total.fetch_add(1, std::memory_order_relaxed);
+	sum.fetch_add(ns, std::memory_order_relaxed);
+	std::uint64_t prev = most.load(std::memory_order_relaxed);
+	while ((ns > prev) && !most.compare_exchange_weak(
+		prev, ns, std::memory_order_relaxed
+	)) { }
+}
+
+double MetricHistogram::mean() const {
+	std::uint64_t c = count();
+	if (!c) {
+		return 0;
+	}
+	return (double)sum.load(std::memory_order_relaxed) / 1e9 / (double)c;
+}
+
+void MetricHistogram::write(std::ostream &os) const {
+	writeHeader(os, name(), help(), "histogram");
+	// the format wants cumulative counts
+	std::uint64_t cumulative = 0;
+	for (std::size_t b = 0; b < bounds.size(); ++b) {
+		cumulative += buckets[b].load(std::memory_order_relaxed);
+		os << name() << "_bucket{le=\"" << bounds[b] << "\"} " << cumulative <<
+		'\n';
+	}
+	cumulative += buckets[bounds.size()].load(std::memory_order_relaxed);
+	os << name() << "_bucket{le=\"+Inf\"} " << cumulative << '\n' <<
+	name() << "_sum " << (double)sum.load(std::memory_order_relaxed) / 1e9 <<
+	'\n' << name() << "_count " << cumulative << '\n';
+}
+
+void MetricRegistry::write(std::ostream &os) const {
+	for (const Metric *m : metrics) {
+		m->write(os);
+	}
+}
+
+EclipseMetrics::EclipseMetrics() :
+umbraChecks(*this,
+	"eclipse_umbra_checks_total",
+	"Checks of the location against the umbra shapes."
+),
+umbraCheckTime(*this,
+	"eclipse_umbra_check_seconds",
+	"Time taken by each umbra check.",
+	{ 0.01, 0.03, 0.1, 0.3, 1.0, 3.0, 10.0 }
+),
+umbraPrefiltered(*this,
+	"eclipse_umbra_prefiltered_total",
+	"Umbra checks answered by the Besselian element prefilter alone."
+),
+framesRendered(*this,
+	"eclipse_frames_rendered_total",
+	"Frames rendered and written to the display."
+),
+frameWriteTime(*this,
+	"eclipse_frame_write_seconds",
+	"Time taken writing a frame to the display.",
+	{ 0.001, 0.003, 0.01, 0.03, 0.1, 0.3 }
+),
+alarmLateness(*this,
+	"eclipse_alarm_lateness_seconds",
+	"How late each change of the buzzer's output occurred.",
+	{ 0.0001, 0.0003, 0.001, 0.003, 0.01, 0.03, 0.1 }
+),
+gpsReports(*this,
+	"eclipse_gps_reports_total",
+	"Reports received from the GPS."
+),
+i2cErrors(*this,
+	"eclipse_i2c_errors_total",
+	"Failed attempts to open or sample an I2C sensor."
+),
+ephemerisHits(*this,
+	"eclipse_ephemeris_hits_total",
+	"Sun positions computed from the cached ephemeris fits."
+),
+ephemerisMisses(*this,
+	"eclipse_ephemeris_misses_total",
+	"Sun positions computed without the ephemeris fits."
+) { }
@@ -0,0 +1,169 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <boost/noncopyable.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+class MetricRegistry;
+
+/**
+ * A named measure of the program's operation that can be written in the
+ * Prometheus text format. Updates use relaxed atomic operations, so they are
+ * cheap and never block; a reader may see one metric a little ahead of
+ * another.
+ * @author  Jeff Jackowski
+ */
+class Metric : boost::noncopyable {
+	const char *nm;
+	const char *hlp;
+public:
+	/**
+	 * Adds the metric to a registry.
+	 * @param reg   The registry; must outlive the metric.
+	 * @param name  The metric's name; must be a string literal.
+	 * @param help  A description; must be a string literal.
+	 */
+	Metric(MetricRegistry &reg, const char *name, const char *help);
+	virtual ~Metric() = default;
+	const char *name() const {
+		return nm;
+	}
+	const char *help() const {
+		return hlp;
+	}
+	/**
+	 * Writes the metric in the Prometheus text format.
+	 */
+	virtual void write(std::ostream &os) const = 0;
+};
+
+/**
+ * A count that only goes up.
+ */
+class MetricCounter : public Metric {
+	std::atomic<std::uint64_t> value;
+public:
+	MetricCounter(MetricRegistry &reg, const char *name, const char *help) :
+	Metric(reg, name, help), value(0) { }
+	void inc(std::uint64_t n = 1) {
+		value.fetch_add(n, std::memory_order_relaxed);
+	}
+	std::uint64_t get() const {
+		return value.load(std::memory_order_relaxed);
+	}
+	virtual void write(std::ostream &os) const;
+};
+
+/**
+ * Counts observations of a time in buckets by upper bound, and keeps their
+ * sum and the largest.
+ */
+class MetricHistogram : public Metric {
+	/**
+	 * Upper bounds of the buckets in seconds, in increasing order.
+	 */
+	std::vector<double> bounds;
+	/**
+	 * Non-cumulative counts for each bucket, plus one for larger times.
+	 */
+	std::unique_ptr<std::atomic<std::uint64_t>[]> buckets;
+	std::atomic<std::uint64_t> total;
+	/**
+	 * Sum of the observations in nanoseconds.
+	 */
+	std::atomic<std::uint64_t> sum;
+	/**
+	 * Largest observation in nanoseconds.
+	 */
+	std::atomic<std::uint64_t> most;
+public:
+	/**
+	 * @param bnds  Upper bounds of the buckets in seconds.
+	 */
+	MetricHistogram(
+		MetricRegistry &reg,
+		const char *name,
+		const char *help,
+		std::initializer_list<double> bnds
+	);
+	/**
+	 * Records a time; negative times count as zero.
+	 */
+	void observe(std::chrono::nanoseconds t);
+	/**
+	 * The number of observations.
+	 */
+	std::uint64_t count() const {
+		return total.load(std::memory_order_relaxed);
+	}
+	/**
+	 * The mean of the observations in seconds, or zero if there are none.
+	 */
+	double mean() const;
+	/**
+	 * The largest observation in seconds.
+	 */
+	double max() const {
+		return (double)most.load(std::memory_order_relaxed) / 1e9;
+	}
+	virtual void write(std::ostream &os) const;
+};
+
+/**
+ * Keeps a list of metrics for writing them all out. Metrics are added when
+ * constructed, which must be done before any are written; the list is not
+ * protected.
+ * @author  Jeff Jackowski
+ */
+class MetricRegistry : boost::noncopyable {
+	std::vector<const Metric*> metrics;
+public:
+	void add(const Metric *m) {
+		metrics.push_back(m);
+	}
+	/**
+	 * Writes all the metrics in the Prometheus text format.
+	 */
+	void write(std::ostream &os) const;
+};
+
+/**
+ * The metrics for this program.
+ */
+struct EclipseMetrics : MetricRegistry {
+	MetricCounter umbraChecks;
+	MetricHistogram umbraCheckTime;
+	MetricCounter umbraPrefiltered;
+	MetricCounter framesRendered;
+	MetricHistogram frameWriteTime;
+	MetricHistogram alarmLateness;
+	MetricCounter gpsReports;
+	MetricCounter i2cErrors;
+	MetricCounter ephemerisHits;
+	MetricCounter ephemerisMisses;
+	EclipseMetrics();
+};
+
+/**
+ * The program's metrics; always collected.
+ */
+extern EclipseMetrics metrics;
+
+#endif        //  #ifndef METRICS_HPP
@@ -0,0 +1,190 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "MetricsServer.hpp"
+#include <boost/exception/errinfo_errno.hpp>
+#include <boost/exception/errinfo_file_name.hpp>
+#include <boost/throw_exception.hpp>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+constexpr std::size_t MetricsServer::maxClients;
+constexpr std::chrono::seconds MetricsServer::clientTimeout;
+
+MetricsServer::MetricsServer(
+	duds::os::linux::Poller &p,
+	const MetricRegistry &reg,
+	const std::string &where
+) : poller(p), registry(reg) {
+	bool tcp = !where.empty() &&
+		(where.find_first_not_of("0123456789") == std::string::npos);
+	unsigned long port = 0;
+	if (tcp) {
+		// the length check keeps stoul from overflowing
+		if (where.size() <= 5) {
+			port = std::stoul(where);
+		}
+		if ((port < 1) || (port > 65535)) {
+			BOOST_THROW_EXCEPTION(MetricsServerBadPort() <<
+				MetricsServerPort(where)
+			);
+		}
+		listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	} else {
+		listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	}
+	if (listener < 0) {
+		BOOST_THROW_EXCEPTION(MetricsServerError() <<
+			boost::errinfo_errno(errno)
+		);
+	}
+	int result;
+	if (tcp) {
+		int on = 1;
+		setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+		sockaddr_in addr = { };
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons((std::uint16_t)port);
+		// only local; a laptop gets at it through an SSH tunnel
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		result = bind(listener, (sockaddr*)&addr, sizeof(addr));
+	} else {
+		sockaddr_un addr = { };
+		addr.sun_family = AF_UNIX;
+		if (where.size() >= sizeof(addr.sun_path)) {
+			close(listener);
+			BOOST_THROW_EXCEPTION(MetricsServerError() <<
+				boost::errinfo_errno(ENAMETOOLONG) <<
+				boost::errinfo_file_name(where)
+			);
+		}
+		std::strcpy(addr.sun_path, where.c_str());
+		// a socket left from an earlier run would prevent binding
+		unlink(where.c_str());
+		result = bind(listener, (sockaddr*)&addr, sizeof(addr));
+		path = where;
+	}
+	if ((result < 0) || (listen(listener, 4) < 0)) {
+		int err = errno;
+		close(listener);
+		BOOST_THROW_EXCEPTION(MetricsServerError() <<
+			boost::errinfo_errno(err) <<
+			boost::errinfo_file_name(where)
+		);
+	}
+	poller.add(this, listener);
+}
+
+MetricsServer::~MetricsServer() {
+	for (auto &c : clients) {
+		poller.remove(c.first);
+		close(c.first);
+	}
+	poller.remove(listener);
+	close(listener);
+	if (!path.empty()) {
+		unlink(path.c_str());
+	}
+}
+
+void MetricsServer::send(int fd) {
+	std::ostringstream body;
+	registry.write(body);
+	std::string text;
+	if (path.empty()) {
+		std::ostringstream head;
+		head << "HTTP/1.0 200 OK\r\n"
+		"Content-Type: text/plain; version=0.0.4\r\n"
+		"Content-Length: " << body.str().size() << "\r\n"
+		"Connection: close\r\n\r\n";
+		text = head.str();
+	}
+	text += body.str();
+	// small enough to fit in the socket's buffer; a client that can't take
+	// it all at once gets less, and one that has gone away must not raise
+	// SIGPIPE
+	const char *data = text.data();
+	std::size_t left = text.size();
+	while (left) {
+		ssize_t sent = ::send(fd, data, left, MSG_NOSIGNAL);
+		if (sent <= 0) {
+			break;
+		}
+		data += sent;
+		left -= sent;
+	}
+	close(fd);
+}
+
+void MetricsServer::dropStale(std::chrono::steady_clock::time_point now) {
+	for (auto iter = clients.begin(); iter != clients.end();) {
+		if ((now - iter->second.accepted) > clientTimeout) {
+			poller.remove(iter->first);
+			close(iter->first);
+			iter = clients.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+}
+
+void MetricsServer::respond(duds::os::linux::Poller *, int fd) {
+	if (fd == listener) {
+		int client;
+		while ((client = accept4(
+			listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC
+		)) >= 0) {
+			if (!path.empty()) {
+				// no request on the Unix socket; just send
+				send(client);
+				continue;
+			}
+			std::chrono::steady_clock::time_point now =
+				std::chrono::steady_clock::now();
+			dropStale(now);
+			if (clients.size() >= maxClients) {
+				close(client);
+			} else {
+				clients[client].accepted = now;
+				poller.add(this, client);
+			}
+		}
+		return;
+	}
+	auto iter = clients.find(fd);
+	if (iter == clients.end()) {
+		return;
+	}
+	char buff[512];
+	ssize_t got;
+	while ((got = read(fd, buff, sizeof(buff))) > 0) {
+		iter->second.request.append(buff, got);
+	}
+	bool done = iter->second.request.find("\r\n\r\n") != std::string::npos;
+	// closed, failed, or sending far more than a request for metrics needs
+	bool failed = (got == 0) || ((got < 0) && (errno != EAGAIN) &&
+		(errno != EWOULDBLOCK)) || (iter->second.request.size() > 8192);
+	if (done || failed) {
+		poller.remove(fd);
+		clients.erase(iter);
+		if (done) {
+			send(fd);
+		} else {
+			close(fd);
+		}
+	}
+}
@@ -0,0 +1,109 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef METRICSSERVER_HPP
+#define METRICSSERVER_HPP
+
+#include <duds/os/linux/Poller.hpp>
+#include <boost/exception/info.hpp>
+#include "Metrics.hpp"
+#include <chrono>
+#include <map>
+#include <string>
+
+struct MetricsServerError : virtual std::exception, virtual boost::exception { };
+/**
+ * The TCP port number is not in the range 1 to 65535.
+ */
+struct MetricsServerBadPort : MetricsServerError { };
+typedef boost::error_info<struct Info_Port, std::string>  MetricsServerPort;
+
+/**
+ * Serves the metrics of a MetricRegistry in the Prometheus text format from
+ * a Poller. Given a port number, it listens on localhost with TCP and answers
+ * any HTTP request, so the metrics can be fetched with curl or scraped by
+ * Prometheus through an SSH tunnel. Given anything else, it makes a Unix
+ * socket at that path and writes the metrics to each connection, which can
+ * be read with something like "socat - UNIX-CONNECT:path".
+ *
+ * HTTP clients that have not finished their request within clientTimeout
+ * of connecting are dropped when the next connection is accepted, so idle
+ * connections cannot hold all the client slots.
+ * @author  Jeff Jackowski
+ */
+class MetricsServer : public duds::os::linux::PollResponder,
+boost::noncopyable {
+	duds::os::linux::Poller &poller;
+	const MetricRegistry &registry;
+	/**
+	 * The Unix socket's path; empty when using TCP.
+	 */
+	std::string path;
+	/**
+	 * An HTTP client waiting on the end of its request.
+	 */
+	struct Client {
+		/**
+		 * What the client has sent so far.
+		 */
+		std::string request;
+		/**
+		 * When the connection was accepted.
+		 */
+		std::chrono::steady_clock::time_point accepted;
+	};
+	/**
+	 * HTTP clients by file descriptor.
+	 */
+	std::map<int, Client> clients;
+	int listener;
+	/**
+	 * The most HTTP clients handled at once; more are turned away.
+	 */
+	static constexpr std::size_t maxClients = 4;
+	/**
+	 * How long an HTTP client may take to send its request.
+	 */
+	static constexpr std::chrono::seconds clientTimeout =
+		std::chrono::seconds(5);
+	/**
+	 * Closes the connections of HTTP clients that have been waiting longer
+	 * than clientTimeout.
+	 */
+	void dropStale(std::chrono::steady_clock::time_point now);
+	/**
+	 * Writes the metrics, preceded by an HTTP header when using TCP, and
+	 * closes the connection.
+	 */
+	void send(int fd);
+public:
+	/**
+	 * Starts listening.
+	 * @param p      The Poller that will handle the connections.
+	 * @param reg    The metrics to serve.
+	 * @param where  A TCP port number on localhost, or a path for a Unix
+	 *               socket.
+	 * @throw MetricsServerBadPort  The port number is out of range.
+	 * @throw MetricsServerError    The socket could not be made.
+	 */
+	MetricsServer(
+		duds::os::linux::Poller &p,
+		const MetricRegistry &reg,
+		const std::string &where
+	);
+	~MetricsServer();
+	/**
+	 * Accepts connections and reads requests; used by the Poller.
+	 */
+	virtual void respond(duds::os::linux::Poller *, int fd);
+};
+
+#endif        //  #ifndef METRICSSERVER_HPP
@@ -10,7 +10,9 @@
  * Copyright (C) 2024  Jeff Jackowski
  */
 #include "Pages.hpp"
+#include "Metrics.hpp"
 #include "Screen.hpp"
+#include <cmath>
 
 Page::SelectionResponse ClockPage::select(
 	const DisplayInfo &di,
@@ -41,7 +43,8 @@ void GpsPage::show(const DisplayInfo &di, Screen *scr) {
 void GpsPage::update(const DisplayInfo &di, Screen *scr) {
 	std::ostringstream oss;
 	if (di.goodfix) {
-		scr->showText("Acc", 0, 0);
+		// dead reckoned positions are marked as estimates
+		scr->showText(di.estimated ? "Est" : "Acc", 0, 0);
 		oss << di.locerr << 'm';
 		scr->showText(oss.str(), 1, 0);
 		scr->showText("Sats", 2, 0);
@@ -93,10 +96,14 @@ Page::SelectionResponse EclipsePage::select(
 }
 
 void EclipsePage::show(const DisplayInfo &di, Screen *scr) {
-	scr->showTitle("Eclipse");
+	scr->showTitle(di.chkest ? "Eclipse est." : "Eclipse");
 }
 
 void EclipsePage::update(const DisplayInfo &di, Screen *scr) {
+	// mark times found from a dead reckoned position
+	if (di.chkchg) {
+		show(di, scr);
+	}
 	if (di.inTotality) {
 		Hms time;
 		int start = di.start - DisplayInfo::beforeTotality;
@@ -151,10 +158,14 @@ Page::SelectionResponse TotalityPage::select(
 }
 
 void TotalityPage::show(const DisplayInfo &di, Screen *scr) {
-	scr->showTitle("Totality");
+	scr->showTitle(di.chkest ? "Totality est." : "Totality");
 }
 
 void TotalityPage::update(const DisplayInfo &di, Screen *scr) {
+	// mark times found from a dead reckoned position
+	if (di.chkchg) {
+		show(di, scr);
+	}
 	if (di.inTotality) {
 		Hms time;
 		if (di.now < di.start) {
@@ -196,6 +207,126 @@ void TotalityPage::hide(const DisplayInfo &di, Screen *scr) {
 }
 
 
+void ObscurationPage::circumstances(const Location &l) {
+	if ((l.lon != loc.lon) || (l.lat != loc.lat)) {
+		loc = l;
+		bessel.local(lc, loc);
+	}
+}
+
+double ObscurationPage::crossing(double target, double t0, double t1) const {
+	double mag, obs0, obs;
+	bessel.coverage(mag, obs0, loc, t0);
+	// bisect to better than a second
+	while ((t1 - t0) > 0.5) {
+		double mid = (t0 + t1) / 2.0;
+		bessel.coverage(mag, obs, loc, mid);
+		// same side of the target as the start?
+		if ((obs < target) == (obs0 < target)) {
+			t0 = mid;
+		} else {
+			t1 = mid;
+		}
+	}
+	return t1;
+}
+
+Page::SelectionResponse ObscurationPage::select(
+	const DisplayInfo &di,
+	SelectionCause sc
+) {
+	if (!enabled) {
+		return SkipPage;
+	}
+	circumstances(di.curloc);
+	if ((sc == SelectUser) || (
+		// auto-select only with position fix during the partial eclipse
+		di.goodfix && lc.partial &&
+		(di.now > (lc.c1 - 600)) && (di.now < lc.c4)
+	)) {
+		return SelectPage;
+	}
+	return SkipPage;
+}
+
+void ObscurationPage::labels(Screen *scr) {
+	scr->showText("Obscured", 0, 0);
+	scr->showText("Magnitude", 0, 1);
+	labelled = true;
+}
+
+void ObscurationPage::show(const DisplayInfo &di, Screen *scr) {
+	scr->showTitle("Obscuration");
+	labels(scr);
+}
+
+void ObscurationPage::update(const DisplayInfo &di, Screen *scr) {
+	circumstances(di.curloc);
+	if (!lc.partial) {
+		scr->showText("No eclipse here", 0, 2);
+		scr->hideText(0, 0);
+		scr->hideText(0, 1);
+		scr->hideText(1, 0);
+		scr->hideText(1, 1);
+		scr->hideText(1, 2);
+		labelled = false;
+		return;
+	}
+	// the location may have moved into the partial eclipse
+	if (!labelled) {
+		labels(scr);
+	}
+	double mag, obs, now = di.now;
+	bessel.coverage(mag, obs, loc, now);
+	std::ostringstream oss;
+	oss << std::fixed << std::setprecision(1) << (obs * 100.0) << '%';
+	scr->showText(oss.str(), 1, 0);
+	oss.str(std::string());
+	oss << std::setprecision(3) << std::max(mag, 0.0);
+	scr->showText(oss.str(), 1, 1);
+	oss.str(std::string());
+	Hms time;
+	if (now < lc.c1) {
+		scr->showText("Starts in", 0, 2);
+		time.set((int)(lc.c1 - now));
+	} else if (lc.total && (now >= lc.c2) && (now < lc.c3)) {
+		scr->showText("Total ends", 0, 2);
+		time.set((int)(lc.c3 - now));
+	} else if (now < lc.max) {
+		// next 10% step while the obscuration increases
+		double target = (std::floor(obs * 10.0) + 1.0) / 10.0;
+		if (target > lc.obscuration) {
+			scr->showText("Max in", 0, 2);
+			time.set((int)(lc.max - now));
+		} else {
+			oss << "Next " << (int)std::lround(target * 100.0) << '%';
+			scr->showText(oss.str(), 0, 2);
+			time.set((int)(crossing(target, now, lc.max) - now));
+		}
+	} else if (now < lc.c4) {
+		// next 10% step while the obscuration decreases
+		double target = (std::ceil(obs * 10.0) - 1.0) / 10.0;
+		if (target <= 0) {
+			scr->showText("Ends in", 0, 2);
+			time.set((int)(lc.c4 - now));
+		} else {
+			oss << "Next " << (int)std::lround(target * 100.0) << '%';
+			scr->showText(oss.str(), 0, 2);
+			time.set((int)(crossing(target, now, lc.c4) - now));
+		}
+	} else {
+		scr->showText("Over", 0, 2);
+		scr->hideText(1, 2);
+		return;
+	}
+	scr->showText(time.duration(), 1, 2);
+}
+
+void ObscurationPage::hide(const DisplayInfo &di, Screen *scr) {
+	scr->hideText();
+}
+
+
 SystemPage::SystemPage() : lavg("/proc/loadavg") { }
 
 Page::SelectionResponse SystemPage::select(const DisplayInfo &di, SelectionCause sc) {
@@ -293,3 +424,123 @@ void SensorPage::update(const DisplayInfo &di, Screen *scr) {
 void SensorPage::hide(const DisplayInfo &di, Screen *scr) {
 	scr->hideText();
 }
+
+
+/**
+ * Writes a time interval in seconds using units that keep it short.
+ */
+static void writeInterval(std::ostream &os, double s) {
+	double a = std::fabs(s);
+	if (a < 0.001) {
+		os << std::setprecision(0) << s * 1e6 << "us";
+	} else if (a < 1.0) {
+		os << std::setprecision(1) << s * 1e3 << "ms";
+	} else {
+		os << std::setprecision(1) << s << 's';
+	}
+}
+
+Page::SelectionResponse TimingPage::select(
+	const DisplayInfo &di,
+	SelectionCause sc
+) {
+	if (sc == SelectUser) {
+		return SelectPage;
+	}
+	return SkipPage;
+}
+
+void TimingPage::show(const DisplayInfo &di, Screen *scr) {
+	scr->showTitle("Timing");
+	scr->showText("PPS", 0, 0);
+	scr->showText("Offset", 0, 1);
+	scr->showText("Error", 0, 2);
+	scr->showText("NTP", 2, 0);
+	scr->showText("Err", 2, 1);
+	scr->showText("Worst", 2, 2);
+}
+
+void TimingPage::update(const DisplayInfo &di, Screen *scr) {
+	std::ostringstream oss;
+	oss << std::fixed;
+	if (std::isfinite(di.ppsOffset)) {
+		scr->showText("Locked", 1, 0);
+		oss << std::showpos;
+		writeInterval(oss, di.ppsOffset);
+		scr->showText(oss.str(), 1, 1);
+		oss.str(std::string());
+		oss << std::noshowpos;
+		writeInterval(oss, di.ppsError);
+		scr->showText(oss.str(), 1, 2);
+		oss.str(std::string());
+	} else {
+		scr->showText("No lock", 1, 0);
+		scr->hideText(1, 1);
+		scr->hideText(1, 2);
+	}
+	if (std::isfinite(di.clockError)) {
+		scr->showText(di.clockSynced ? "Sync" : "Unsync", 3, 0);
+		writeInterval(oss, di.clockError);
+		scr->showText(oss.str(), 3, 1);
+		oss.str(std::string());
+		// worst over the last hour
+		writeInterval(oss, di.clockWorst);
+		scr->showText(oss.str(), 3, 2);
+	} else {
+		scr->hideText(3, 0);
+		scr->hideText(3, 1);
+		scr->hideText(3, 2);
+	}
+}
+
+void TimingPage::hide(const DisplayInfo &di, Screen *scr) {
+	scr->hideText();
+}
+
+Page::SelectionResponse MetricsPage::select(
+	const DisplayInfo &di,
+	SelectionCause sc
+) {
+	if (sc == SelectUser) {
+		return SelectPage;
+	}
+	return SkipPage;
+}
+
+void MetricsPage::show(const DisplayInfo &di, Screen *scr) {
+	scr->showTitle("Metrics");
+	scr->showText("Frames", 0, 0);
+	scr->showText("Write", 0, 1);
+	scr->showText("Check", 0, 2);
+	scr->showText("GPS", 2, 0);
+	scr->showText("I2C err", 2, 1);
+	scr->showText("Alarm", 2, 2);
+}
+
+void MetricsPage::update(const DisplayInfo &di, Screen *scr) {
+	std::ostringstream oss;
+	oss << std::fixed;
+	oss << metrics.framesRendered.get();
+	scr->showText(oss.str(), 1, 0);
+	oss.str(std::string());
+	// average times
+	writeInterval(oss, metrics.frameWriteTime.mean());
+	scr->showText(oss.str(), 1, 1);
+	oss.str(std::string());
+	writeInterval(oss, metrics.umbraCheckTime.mean());
+	scr->showText(oss.str(), 1, 2);
+	oss.str(std::string());
+	oss << metrics.gpsReports.get();
+	scr->showText(oss.str(), 3, 0);
+	oss.str(std::string());
+	oss << metrics.i2cErrors.get();
+	scr->showText(oss.str(), 3, 1);
+	oss.str(std::string());
+	// the latest any part of a sound has started
+	writeInterval(oss, metrics.alarmLateness.max());
+	scr->showText(oss.str(), 3, 2);
+}
+
+void MetricsPage::hide(const DisplayInfo &di, Screen *scr) {
+	scr->hideText();
+}
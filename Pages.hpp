@@ -10,6 +10,7 @@
  * Copyright (C) 2024  Jeff Jackowski
  */
 #include "Page.hpp"
+#include "Besselian.hpp"
 #include <fstream>
 
 class ClockPage : public Page {
@@ -55,6 +56,61 @@ public:
 	virtual void update(const DisplayInfo &di, Screen *scr);
 };
 
+/**
+ * Shows the current magnitude and obscuration of the sun, and the time until
+ * the obscuration reaches the next multiple of 10%. Everything is computed
+ * from the Besselian elements on each update, which takes a few microseconds.
+ * @author  Jeff Jackowski
+ */
+class ObscurationPage : public Page {
+	Besselian bessel;
+	/**
+	 * False if no Besselian elements are available for the eclipse.
+	 */
+	bool enabled;
+	/**
+	 * Circumstances for the location in @a loc.
+	 */
+	LocalCircumstances lc;
+	Location loc = Location(0, 0);
+	/**
+	 * True when the labels for the obscuration and magnitude are shown.
+	 */
+	bool labelled = false;
+	/**
+	 * Updates @a lc if the location changed.
+	 */
+	void circumstances(const Location &l);
+	/**
+	 * Shows the labels for the obscuration and magnitude.
+	 */
+	void labels(Screen *scr);
+	/**
+	 * Finds the time when the obscuration crosses @a target between times
+	 * @a t0 and @a t1 in seconds from midnight UTC. The obscuration must be
+	 * monotonic between the two times.
+	 */
+	double crossing(double target, double t0, double t1) const;
+public:
+	/**
+	 * @param be  The elements for the eclipse, or nullptr if not known. The
+	 *            elements must outlive this object.
+	 */
+	ObscurationPage(const BesselianElements *be) :
+	bessel(be ? *be : Eclipse20240408), enabled(be != nullptr) {
+		// the location before a fix is the same as the starting location, so
+		// circumstances() will not compute these
+		bessel.local(lc, loc);
+	}
+	virtual SelectionResponse select(
+		const DisplayInfo &di,
+		SelectionCause cause
+	);
+	virtual void show(const DisplayInfo &di, Screen *scr);
+	virtual void hide(const DisplayInfo &di, Screen *scr);
+	virtual void update(const DisplayInfo &di, Screen *scr);
+};
+
 class SystemPage : public Page {
 	std::ifstream lavg;
 public:
@@ -78,3 +134,37 @@ public:
 	virtual void hide(const DisplayInfo &di, Screen *scr);
 	virtual void update(const DisplayInfo &di, Screen *scr);
 };
+
+/**
+ * Shows how well the system clock is known: the offset from the PPS second
+ * and the timing confidence figure, and the clock's error according to NTP
+ * now and at its worst over the last hour.
+ * @author  Jeff Jackowski
+ */
+class TimingPage : public Page {
+public:
+	virtual SelectionResponse select(
+		const DisplayInfo &di,
+		SelectionCause cause
+	);
+	virtual void show(const DisplayInfo &di, Screen *scr);
+	virtual void hide(const DisplayInfo &di, Screen *scr);
+	virtual void update(const DisplayInfo &di, Screen *scr);
+};
+
+/**
+ * Shows a few of the program's metrics: frames rendered and the average
+ * time writing them to the display, the average umbra check time, GPS
+ * reports, I2C errors, and the latest the buzzer has changed.
+ * @author  Jeff Jackowski
+ */
+class MetricsPage : public Page {
+public:
+	virtual SelectionResponse select(
+		const DisplayInfo &di,
+		SelectionCause cause
+	);
+	virtual void show(const DisplayInfo &di, Screen *scr);
+	virtual void hide(const DisplayInfo &di, Screen *scr);
+	virtual void update(const DisplayInfo &di, Screen *scr);
+};
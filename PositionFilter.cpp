@@ -0,0 +1,171 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "PositionFilter.hpp"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Converts a 95% confidence value to a standard deviation.
+ */
+static constexpr double conf95 = 1.96;
+
+/**
+ * Initial velocity variance; a standard deviation of 5 m/s.
+ */
+static constexpr double startVelVar = 25.0;
+
+/**
+ * Returns the variance for a 95% confidence error estimate, or for the given
+ * default if the estimate is not usable.
+ */
+static double variance(double err, double def) {
+	if (!std::isfinite(err) || (err <= 0)) {
+		err = def;
+	}
+	double sd = err / conf95;
+	return sd * sd;
+}
+
+void PositionFilter::Axis::start(double p, double var) {
+	pos = p;
+	vel = 0;
+	pp = var;
+	pv = 0;
+	vv = startVelVar;
+}
+
+void PositionFilter::Axis::predict(double dt, double q) {
+	pos += vel * dt;
+	double dt2 = dt * dt;
+	pp += 2.0 * dt * pv + dt2 * vv + q * dt2 * dt / 3.0;
+	pv += dt * vv + q * dt2 / 2.0;
+	vv += q * dt;
+}
+
+double PositionFilter::Axis::innovation(double z, double var) const {
+	double y = z - pos;
+	return y * y / (pp + var);
+}
+
+void PositionFilter::Axis::position(double z, double var) {
+	double s = pp + var;
+	double k0 = pp / s;
+	double k1 = pv / s;
+	double y = z - pos;
+	pos += k0 * y;
+	vel += k1 * y;
+	vv -= k1 * pv;
+	pp *= 1.0 - k0;
+	pv *= 1.0 - k0;
+}
+
+void PositionFilter::Axis::velocity(double z, double var) {
+	double s = vv + var;
+	double k0 = pv / s;
+	double k1 = vv / s;
+	double y = z - vel;
+	pos += k0 * y;
+	vel += k1 * y;
+	pp -= k0 * pv;
+	pv *= 1.0 - k1;
+	vv *= 1.0 - k1;
+}
+
+void PositionFilter::reanchor() {
+	if (std::max(std::fabs(east.pos), std::fabs(north.pos)) > LocalFrame::range / 2) {
+		Location loc = position();
+		lf.anchor(loc);
+		// the velocity and covariance change little over this distance
+		east.pos = north.pos = 0;
+	}
+}
+
+void PositionFilter::update(
+	double time,
+	const Location &loc,
+	double errE,
+	double errN
+) {
+	// no position to use
+	if (!std::isfinite(loc.lon) || !std::isfinite(loc.lat)) {
+		return;
+	}
+	double varE = variance(errE, defaultError);
+	double varN = variance(errN, defaultError);
+	if (init) {
+		double dt = time - last;
+		if (dt > 0) {
+			east.predict(dt, accelNoise);
+			north.predict(dt, accelNoise);
+		}
+		Enu z = lf.toEnu(loc);
+		if (
+			(east.innovation(z.east, varE) + north.innovation(z.north, varN)) <
+			restartGate
+		) {
+			east.position(z.east, varE);
+			north.position(z.north, varN);
+			last = time;
+			reanchor();
+			return;
+		}
+	}
+	// start over
+	lf.anchor(loc);
+	east.start(0, varE);
+	north.start(0, varN);
+	last = time;
+	init = true;
+}
+
+void PositionFilter::velocity(double speed, double track, double err) {
+	if (!init || !std::isfinite(speed) || !std::isfinite(track)) {
+		return;
+	}
+	double var = variance(err, defaultError / 4.0);
+	double rad = track * M_PI / 180.0;
+	east.velocity(speed * std::sin(rad), var);
+	north.velocity(speed * std::cos(rad), var);
+}
+
+bool PositionFilter::extrapolate(
+	double time,
+	Location &loc,
+	double &err
+) const {
+	double dt = time - last;
+	if (!init || !(dt >= 0) || (dt > maxCoast)) {
+		return false;
+	}
+	Axis e = east, n = north;
+	e.predict(dt, accelNoise);
+	n.predict(dt, accelNoise);
+	double u = conf95 * std::sqrt(std::max(e.pp, n.pp));
+	if (u > maxCoastError) {
+		return false;
+	}
+	loc = lf.toLocation(Enu(e.pos, n.pos));
+	err = u;
+	return true;
+}
+
+Location PositionFilter::position() const {
+	return lf.toLocation(Enu(east.pos, north.pos));
+}
+
+double PositionFilter::speed() const {
+	return std::sqrt(east.vel * east.vel + north.vel * north.vel);
+}
+
+double PositionFilter::uncertainty() const {
+	return conf95 * std::sqrt(std::max(east.pp, north.pp));
+}
@@ -0,0 +1,175 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef POSITIONFILTER_HPP
+#define POSITIONFILTER_HPP
+
+#include "Geodesy.hpp"
+
+/**
+ * A constant velocity Kalman filter for GPS positions. The state is the
+ * position and velocity in a LocalFrame. With noise that is independent in
+ * the east and north directions, the four state filter separates into one
+ * two state filter for each direction, which is how it is implemented.
+ *
+ * The measurement noise comes from the error estimates reported by the GPS.
+ * The process noise models the unknown acceleration as white noise of
+ * @a accelNoise. A measurement far outside the estimate's uncertainty
+ * restarts the filter at the measurement; see @a restartGate.
+ * @author  Jeff Jackowski
+ */
+class PositionFilter {
+	/**
+	 * The filter for one direction.
+	 */
+	struct Axis {
+		double pos;
+		double vel;
+		/**
+		 * Covariance: position variance, cross term, velocity variance.
+		 */
+		double pp, pv, vv;
+		void start(double p, double var);
+		void predict(double dt, double q);
+		/**
+		 * Returns the squared difference of a measured position from the
+		 * estimate divided by its variance.
+		 */
+		double innovation(double z, double var) const;
+		/**
+		 * Updates with a measurement of the position.
+		 */
+		void position(double z, double var);
+		/**
+		 * Updates with a measurement of the velocity.
+		 */
+		void velocity(double z, double var);
+	};
+	LocalFrame lf;
+	Axis east, north;
+	/**
+	 * Time of the last update in seconds.
+	 */
+	double last;
+	bool init = false;
+	/**
+	 * Moves the frame to the current position if the position has moved far
+	 * from the frame's origin.
+	 */
+	void reanchor();
+public:
+	/**
+	 * Spectral density of the acceleration noise in m²/s³. Covers walking
+	 * around and gentle driving without letting GPS noise through.
+	 */
+	static constexpr double accelNoise = 0.5;
+	/**
+	 * Error in meters assumed when the GPS does not report one.
+	 */
+	static constexpr double defaultError = 10.0;
+	/**
+	 * A position measurement with a squared distance from the estimate, in
+	 * units of variance and summed over both directions, greater than this
+	 * restarts the filter rather than slowly dragging the estimate over.
+	 * About ten standard deviations.
+	 */
+	static constexpr double restartGate = 100.0;
+	/**
+	 * Longest time in seconds after the last position update that
+	 * extrapolate() will estimate a position.
+	 */
+	static constexpr double maxCoast = 60.0;
+	/**
+	 * Largest uncertainty in meters, as a 95% confidence radius, of a
+	 * position given by extrapolate(). The uncertainty grows with the cube
+	 * of the time without a fix, so this usually ends an estimate before
+	 * @a maxCoast when moving with a poorly known velocity.
+	 */
+	static constexpr double maxCoastError = 500.0;
+	/**
+	 * Forgets the current estimate; the next position update will start
+	 * the filter over.
+	 */
+	void reset() {
+		init = false;
+	}
+	/**
+	 * True once a position has been given since construction or reset().
+	 */
+	bool initialized() const {
+		return init;
+	}
+	/**
+	 * Adds a position measurement.
+	 * @param time   The time of the fix in seconds; only differences
+	 *               between calls matter.
+	 * @param loc    The measured location.
+	 * @param errE   The east error estimate in meters as a 95% confidence
+	 *               value, like gpsd's epx. Not-a-number is allowed.
+	 * @param errN   The north error estimate in meters; like gpsd's epy.
+	 */
+	void update(double time, const Location &loc, double errE, double errN);
+	/**
+	 * Adds a velocity measurement for the time of the last position update.
+	 * @param speed  Speed over ground in m/s.
+	 * @param track  Direction of travel in degrees clockwise from north.
+	 * @param err    The speed error estimate in m/s as a 95% confidence
+	 *               value, like gpsd's eps.
+	 */
+	void velocity(double speed, double track, double err);
+	/**
+	 * Estimates the position at a time after the last update from the
+	 * filtered velocity, for use while the GPS has no fix. The filter is
+	 * not changed; the next update will account for the elapsed time.
+	 * @param time  The time of the estimate in seconds; the same clock as
+	 *              given to update().
+	 * @param loc   The estimated location.
+	 * @param err   The uncertainty of the estimate in meters as a 95%
+	 *              confidence radius.
+	 * @return      False if there is no estimate, it is more than
+	 *              @a maxCoast seconds old, or its uncertainty exceeds
+	 *              @a maxCoastError. The output parameters are not changed.
+	 */
+	bool extrapolate(double time, Location &loc, double &err) const;
+	/**
+	 * The filtered location.
+	 */
+	Location position() const;
+	/**
+	 * The filtered position in the filter's local frame.
+	 */
+	Enu enu() const {
+		return Enu(east.pos, north.pos);
+	}
+	/**
+	 * The filtered velocity in m/s.
+	 */
+	Enu enuVelocity() const {
+		return Enu(east.vel, north.vel);
+	}
+	/**
+	 * The filtered speed in m/s.
+	 */
+	double speed() const;
+	/**
+	 * The horizontal position uncertainty as a 95% confidence radius in
+	 * meters, comparable to the error values reported by gpsd.
+	 */
+	double uncertainty() const;
+	/**
+	 * The local frame used for the position.
+	 */
+	const LocalFrame &frame() const {
+		return lf;
+	}
+};
+
+#endif        //  #ifndef POSITIONFILTER_HPP
@@ -0,0 +1,147 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "PpsInput.hpp"
+#include "Trace.hpp"
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/exception/errinfo_errno.hpp>
+#include <boost/exception/errinfo_file_name.hpp>
+#include <boost/throw_exception.hpp>
+#include <linux/pps.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <iostream>
+
+constexpr std::chrono::milliseconds PpsInput::staleTime;
+
+PpsInput::PpsInput(const std::string &path) : stop(false) {
+	dev = open(path.c_str(), O_RDWR | O_CLOEXEC);
+	if (dev < 0) {
+		// reading is enough if the mode is already set
+		dev = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	}
+	if (dev < 0) {
+		BOOST_THROW_EXCEPTION(PpsOpenError() <<
+			boost::errinfo_errno(errno) <<
+			boost::errinfo_file_name(path)
+		);
+	}
+	int caps;
+	if (ioctl(dev, PPS_GETCAP, &caps) < 0) {
+		int err = errno;
+		close(dev);
+		BOOST_THROW_EXCEPTION(PpsOpenError() <<
+			boost::errinfo_errno(err) <<
+			boost::errinfo_file_name(path)
+		);
+	}
+	if (!(caps & PPS_CAPTUREASSERT) || !(caps & PPS_CANWAIT)) {
+		close(dev);
+		BOOST_THROW_EXCEPTION(PpsNotSupported() <<
+			boost::errinfo_file_name(path)
+		);
+	}
+	pps_kparams params;
+	if (
+		(ioctl(dev, PPS_GETPARAMS, &params) == 0) &&
+		((params.mode & (PPS_CAPTUREASSERT | PPS_TSFMT_TSPEC)) !=
+		(PPS_CAPTUREASSERT | PPS_TSFMT_TSPEC))
+	) {
+		params.mode |= PPS_CAPTUREASSERT | PPS_TSFMT_TSPEC;
+		// may fail without permission; the fetch will fail later if the
+		// mode is really needed
+		ioctl(dev, PPS_SETPARAMS, &params);
+	}
+	running = std::thread(&PpsInput::run, this);
+}
+
+PpsInput::~PpsInput() {
+	stop = true;
+	// the thread notices within one fetch timeout
+	if (running.joinable()) {
+		running.join();
+	}
+	close(dev);
+}
+
+void PpsInput::pulse(long nsec) {
+	// the fraction of a second from the nearest second
+	double off = (double)nsec / 1e9;
+	if (off >= 0.5) {
+		off -= 1.0;
+	}
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	++timing.pulses;
+	lastPulse = Clock::now();
+	offsets[pos] = off;
+	pos = (pos + 1) % history;
+	if (count < history) {
+		++count;
+	}
+	double sum = 0;
+	for (int i = 0; i < count; ++i) {
+		sum += offsets[i];
+	}
+	timing.offset = sum / (double)count;
+	sum = 0;
+	for (int i = 0; i < count; ++i) {
+		double d = offsets[i] - timing.offset;
+		sum += d * d;
+	}
+	timing.jitter = std::sqrt(sum / (double)count);
+}
+
+void PpsInput::run()
+try {
+	TRACE_THREAD("pps");
+	pps_fdata fetch;
+	while (!stop) {
+		// wait long enough to see a pulse, but not so long that stopping
+		// is delayed much
+		fetch.timeout.sec = 1;
+		fetch.timeout.nsec = 500000000;
+		fetch.timeout.flags = 0;
+		if (ioctl(dev, PPS_FETCH, &fetch) < 0) {
+			int err = errno;
+			if (err == ETIMEDOUT) {
+				std::lock_guard<duds::general::Spinlock> lock(block);
+				++timing.missed;
+			} else if (err != EINTR) {
+				BOOST_THROW_EXCEPTION(PpsError() <<
+					boost::errinfo_errno(err)
+				);
+			}
+		} else {
+			// the fetch waits for a new pulse
+			pulse(fetch.info.assert_tu.nsec);
+		}
+	}
+} catch (...) {
+	std::cerr << "PPS input failed:\n" <<
+	boost::current_exception_diagnostic_information() << std::endl;
+}
+
+PpsTiming PpsInput::status() const {
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	PpsTiming t = timing;
+	t.locked = (count >= minPulses) && ((Clock::now() - lastPulse) < staleTime);
+	return t;
+}
+
+bool PpsInput::offset(double &off) const {
+	PpsTiming t = status();
+	if (t.locked) {
+		off = t.offset;
+	}
+	return t.locked;
+}
@@ -0,0 +1,154 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef PPSINPUT_HPP
+#define PPSINPUT_HPP
+
+#include <boost/exception/info.hpp>
+#include <boost/noncopyable.hpp>
+#include <duds/general/Spinlock.hpp>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <thread>
+
+struct PpsError : virtual std::exception, virtual boost::exception { };
+/**
+ * The PPS device could not be opened.
+ */
+struct PpsOpenError : PpsError { };
+/**
+ * The PPS device cannot capture and wait for the start of a pulse.
+ */
+struct PpsNotSupported : PpsError { };
+
+/**
+ * The state of the system clock as measured against a PPS signal.
+ */
+struct PpsTiming {
+	/**
+	 * The mean difference in seconds of the system clock from the start of
+	 * the true second; positive when the system clock is ahead.
+	 */
+	double offset = NAN;
+	/**
+	 * Standard deviation of the recent offsets in seconds.
+	 */
+	double jitter = NAN;
+	/**
+	 * Total pulses seen.
+	 */
+	unsigned long pulses = 0;
+	/**
+	 * Waits of over a second that ended without a pulse.
+	 */
+	unsigned long missed = 0;
+	/**
+	 * True when enough recent pulses have been seen to trust the offset.
+	 */
+	bool locked = false;
+	/**
+	 * The timing confidence figure: the likely error in seconds, as a 95%
+	 * confidence value, of a time corrected by @a offset. Not-a-number when
+	 * not locked.
+	 */
+	double error() const {
+		return locked ? 2.0 * jitter : NAN;
+	}
+};
+
+/**
+ * Measures the system clock against the pulse-per-second output of a GPS
+ * receiver through the Linux PPS API, such as /dev/pps0 from the pps-gpio
+ * driver. The kernel timestamps the start of each pulse with the system
+ * clock, so the fractional part of the timestamp is how far the clock is
+ * from the true second. This is independent of whatever NTP is doing.
+ *
+ * The PPS device cannot be used with epoll, so a thread waits on it. The
+ * pulse only marks the start of some second; the system clock must already
+ * be within half a second of the right time to label it, which a GPS fed
+ * NTP server or even a network time source easily provides.
+ * @author  Jeff Jackowski
+ */
+class PpsInput : boost::noncopyable {
+public:
+	/**
+	 * Number of recent pulses used for the offset and jitter.
+	 */
+	static constexpr int history = 16;
+	/**
+	 * Fewest recent pulses needed to be locked.
+	 */
+	static constexpr int minPulses = 4;
+	/**
+	 * Time without a pulse after which the offset is no longer trusted.
+	 */
+	static constexpr std::chrono::milliseconds staleTime =
+		std::chrono::milliseconds(2500);
+private:
+	typedef std::chrono::steady_clock Clock;
+	mutable duds::general::Spinlock block;
+	std::thread running;
+	/**
+	 * Recent offsets in a circular buffer.
+	 */
+	double offsets[history];
+	/**
+	 * When the last pulse was received.
+	 */
+	Clock::time_point lastPulse;
+	PpsTiming timing;
+	/**
+	 * Number of valid entries in @a offsets.
+	 */
+	int count = 0;
+	/**
+	 * Index of the next entry to replace in @a offsets.
+	 */
+	int pos = 0;
+	int dev;
+	std::atomic_bool stop;
+	/**
+	 * Records a pulse timestamped with the given nanoseconds past the
+	 * second by the system clock.
+	 */
+	void pulse(long nsec);
+	/**
+	 * Waits for pulses until told to stop.
+	 */
+	void run();
+public:
+	/**
+	 * Opens the PPS device, configures it to capture the start of each
+	 * pulse, and starts a thread to wait on it.
+	 * @param path  The device, such as /dev/pps0.
+	 * @throw PpsOpenError     The device could not be opened or queried.
+	 * @throw PpsNotSupported  The device cannot capture assert events or
+	 *                         wait for them.
+	 */
+	PpsInput(const std::string &path);
+	~PpsInput();
+	/**
+	 * Returns the current measurements. Thread-safe.
+	 */
+	PpsTiming status() const;
+	/**
+	 * Provides the offset of the system clock from the true second when
+	 * locked. Thread-safe.
+	 * @param off  The offset in seconds; positive when the system clock is
+	 *             ahead. Not changed if not locked.
+	 * @return     True if locked.
+	 */
+	bool offset(double &off) const;
+};
+
+#endif        //  #ifndef PPSINPUT_HPP
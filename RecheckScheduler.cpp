@@ -0,0 +1,207 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "RecheckScheduler.hpp"
+#include <mutex>
+#include <cmath>
+#include <limits>
+
+/**
+ * Distance in meters to the points used to find the rate of change from the
+ * Besselian elements.
+ */
+static constexpr double step = 100.0;
+
+/**
+ * Approximate meters per Earth radius for the umbra distance from
+ * LocalCircumstances. Distances on the fundamental plane are no larger than
+ * those on the ground, so this does not overestimate the distance to the
+ * edge.
+ */
+static constexpr double metersPerRadius = 6378000.0;
+
+static constexpr double inf = std::numeric_limits<double>::infinity();
+
+void RecheckScheduler::fromElements() {
+	Besselian bes(*elements);
+	LocalCircumstances lc;
+	bes.local(lc, last.loc);
+	edge = std::fabs(lc.umbraDistance) * metersPerRadius;
+	if (!lc.total) {
+		// no contact times to change; only crossing the edge matters
+		gradient = true;
+		gradStart = gradEnd = Enu(0, 0);
+		return;
+	}
+	LocalFrame lf(last.loc);
+	// contact times at points to the east, north, west, and south
+	const Enu offsets[4] = {
+		Enu(step, 0), Enu(0, step), Enu(-step, 0), Enu(0, -step)
+	};
+	double c2[4], c3[4];
+	bool good[4];
+	for (int i = 0; i < 4; ++i) {
+		LocalCircumstances olc;
+		bes.local(olc, lf.toLocation(offsets[i]));
+		c2[i] = olc.c2;
+		c3[i] = olc.c3;
+		good[i] = olc.total;
+	}
+	// central differences where possible, otherwise one sided
+	auto slope = [&](int pos, int neg, const double *c, double center) {
+		if (good[pos] && good[neg]) {
+			return (c[pos] - c[neg]) / (2.0 * step);
+		} else if (good[pos]) {
+			return (c[pos] - center) / step;
+		} else if (good[neg]) {
+			return (center - c[neg]) / step;
+		}
+		return 0.0;
+	};
+	gradStart = Enu(slope(0, 2, c2, lc.c2), slope(1, 3, c2, lc.c2));
+	gradEnd = Enu(slope(0, 2, c3, lc.c3), slope(1, 3, c3, lc.c3));
+	gradient = true;
+}
+
+void RecheckScheduler::fromResults() {
+	gradient = false;
+	rate = defaultRate;
+	edge = inf;
+	// the farthest result gives the best resolution
+	const Result *prev = nullptr;
+	double dist = 0;
+	for (const Result &r : history) {
+		double d = vincentyEarth(r.loc, last.loc);
+		if (r.inside != last.inside) {
+			// the edge is somewhere between the two
+			edge = std::min(edge, d);
+		}
+		if (d > dist) {
+			prev = &r;
+			dist = d;
+		}
+	}
+	if (!prev || (dist < 1.0) || !last.inside || !prev->inside) {
+		return;
+	}
+	// the results are truncated to whole seconds, so the change could be
+	// nearly a second more than it appears
+	rate = std::max(
+		(double)(std::max(
+			std::abs(last.start - prev->start),
+			std::abs(last.end - prev->end)
+		) + 1) / dist,
+		minRate
+	);
+	// the square of the duration changes about linearly with the distance
+	// from the edge
+	double d0 = prev->end - prev->start;
+	double d1 = last.end - last.start;
+	double sqSlope = std::fabs(d1 * d1 - d0 * d0) / dist;
+	if (sqSlope > 0) {
+		edge = std::min(edge, d1 * d1 / sqSlope);
+	}
+}
+
+double RecheckScheduler::change(const Enu &d) const {
+	if (!last.valid) {
+		return inf;
+	}
+	double moved = d.horizontal();
+	// might be on the other side of the edge; the linear estimate is within
+	// about 20% up to half way to the edge
+	if (moved > (edge * 0.5)) {
+		return inf;
+	}
+	if (gradient) {
+		return std::max(
+			std::fabs(gradStart.east * d.east + gradStart.north * d.north),
+			std::fabs(gradEnd.east * d.east + gradEnd.north * d.north)
+		);
+	}
+	double est = rate * moved;
+	if (last.inside && std::isfinite(edge)) {
+		// the duration shrinks faster approaching the edge, and each contact
+		// takes about half of the change
+		est = std::max(
+			est,
+			0.5 * (last.end - last.start) * (1.0 - std::sqrt(1.0 - moved / edge))
+		);
+	}
+	return est;
+}
+
+bool RecheckScheduler::due(const Location &loc) {
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	if (busy) {
+		return false;
+	}
+	if (forced || ((Clock::now() - checkTime) > maxInterval)) {
+		return true;
+	}
+	return change(frame.toEnu(loc)) > tolerance;
+}
+
+void RecheckScheduler::force() {
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	forced = true;
+}
+
+void RecheckScheduler::started(const Location &loc) {
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	frame.anchor(loc);
+	checkTime = Clock::now();
+	busy = true;
+	forced = false;
+}
+
+void RecheckScheduler::finished(
+	const Location &loc,
+	bool inside,
+	int start,
+	int end
+) {
+	Result res;
+	res.loc = loc;
+	res.inside = inside;
+	res.start = start;
+	res.end = end;
+	res.valid = true;
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	if (last.valid) {
+		history.push_front(last);
+		if (history.size() > historyLength) {
+			history.pop_back();
+		}
+	}
+	last = res;
+	if (elements) {
+		fromElements();
+	} else {
+		fromResults();
+	}
+	busy = false;
+}
+
+void RecheckScheduler::failed() {
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	busy = false;
+}
+
+double RecheckScheduler::distance(const Location &loc) {
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	return frame.distance(loc);
+}
+
+double RecheckScheduler::expectedChange(const Location &loc) {
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	return change(frame.toEnu(loc));
+}
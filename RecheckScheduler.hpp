@@ -0,0 +1,184 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef RECHECKSCHEDULER_HPP
+#define RECHECKSCHEDULER_HPP
+
+#include <duds/general/Spinlock.hpp>
+#include "Besselian.hpp"
+#include "Geodesy.hpp"
+#include <chrono>
+#include <deque>
+
+/**
+ * Decides when the totality check needs to be redone after moving. It
+ * estimates how quickly the contact times change with position around the
+ * last checked location, and asks for a new check only once the expected
+ * change in the contact times exceeds @a tolerance. Deep inside the path the
+ * times change slowly, so a location may drift a few hundred meters before a
+ * recheck; near the edge, where the duration changes quickly, a few meters
+ * may be enough.
+ *
+ * The rate of change comes from the Besselian elements when they are
+ * available: the contact times are found at points around the checked
+ * location, and the distance to the edge of the umbra bounds how far the
+ * linear estimate is trusted. Without elements, the last result is compared
+ * with the farthest of the few before it, which makes the most of the one
+ * second resolution of the results. The duration of totality goes about as the
+ * square root of the distance from the edge, so its square gives an estimate
+ * of that distance. With a single result, a conservative default rate is
+ * used.
+ *
+ * started() is called from the thread deciding on checks, and finished()
+ * from the thread doing them; the state is protected by a spinlock.
+ * @author  Jeff Jackowski
+ */
+class RecheckScheduler {
+	typedef std::chrono::steady_clock Clock;
+	/**
+	 * The result of a check.
+	 */
+	struct Result {
+		Location loc;
+		int start;
+		int end;
+		bool inside;
+		bool valid = false;
+	};
+	Result last;
+	/**
+	 * Earlier results, most recent first, for comparison with @a last.
+	 */
+	std::deque<Result> history;
+	/**
+	 * Frame anchored at the location of the last started check.
+	 */
+	LocalFrame frame;
+	/**
+	 * The elements for estimating the rate of change; may be nullptr.
+	 */
+	const BesselianElements *elements;
+	/**
+	 * Rate of change of the start and end of totality in seconds per meter
+	 * east and north; only used when @a gradient is true.
+	 */
+	Enu gradStart, gradEnd;
+	/**
+	 * Rate of change of the contact times, in seconds per meter, in any
+	 * direction; used when @a gradient is false.
+	 */
+	double rate;
+	/**
+	 * Estimated distance to the edge of the path in meters; infinite if
+	 * unknown.
+	 */
+	double edge;
+	/**
+	 * Time the last check was started.
+	 */
+	Clock::time_point checkTime;
+	duds::general::Spinlock block;
+	bool gradient = false;
+	/**
+	 * True while a check is running.
+	 */
+	bool busy = false;
+	/**
+	 * True when the next check is due regardless of movement.
+	 */
+	bool forced = false;
+	/**
+	 * Finds the rate of change using the Besselian elements.
+	 */
+	void fromElements();
+	/**
+	 * Finds the rate of change by comparing the last result with an earlier
+	 * one.
+	 */
+	void fromResults();
+	/**
+	 * Returns the expected change in the contact times in seconds after moving
+	 * by @a d from the last checked location.
+	 */
+	double change(const Enu &d) const;
+public:
+	/**
+	 * The change in contact times, in seconds, that warrants a recheck.
+	 */
+	static constexpr double tolerance = 0.5;
+	/**
+	 * Rate of change in seconds per meter used until enough is known. Gives
+	 * a recheck after moving 64 meters.
+	 */
+	static constexpr double defaultRate = tolerance / 64.0;
+	/**
+	 * Lowest rate of change in seconds per meter that will be used. The
+	 * contact times change by at least the inverse of the speed of the
+	 * shadow, which is under 2 km/s in the path of most total eclipses.
+	 * Also covers the one second resolution of the check results.
+	 */
+	static constexpr double minRate = 1.0 / 2000.0;
+	/**
+	 * Most earlier results kept for comparison.
+	 */
+	static constexpr std::size_t historyLength = 8;
+	/**
+	 * Longest time between checks. Only a safety net; the results do not
+	 * change without movement.
+	 */
+	static constexpr std::chrono::seconds maxInterval =
+		std::chrono::seconds(900);
+	/**
+	 * Uses the given elements, if not nullptr, to estimate the rate of
+	 * change; they must outlive this object.
+	 */
+	RecheckScheduler(const BesselianElements *be = nullptr) : elements(be) { }
+	/**
+	 * True if a check should be started for the given location. Always false
+	 * while a check is running.
+	 */
+	bool due(const Location &loc);
+	/**
+	 * Makes a check due at the next opportunity, such as when data used by
+	 * the check becomes available. A running check is not counted.
+	 */
+	void force();
+	/**
+	 * Records the start of a check for the given location.
+	 */
+	void started(const Location &loc);
+	/**
+	 * Records the result of the check started at @a loc.
+	 * @param loc     The checked location.
+	 * @param inside  True if the location is inside the path of totality.
+	 * @param start   Start of totality in seconds from midnight UTC.
+	 * @param end     End of totality in seconds from midnight UTC.
+	 */
+	void finished(const Location &loc, bool inside, int start, int end);
+	/**
+	 * Records that the check did not produce a result, so that another may be
+	 * started.
+	 */
+	void failed();
+	/**
+	 * Returns the distance in meters from the location of the last started
+	 * check.
+	 */
+	double distance(const Location &loc);
+	/**
+	 * Returns the expected change in the contact times, in seconds, since the
+	 * last check if the location is now at @a loc. Infinite if no check has
+	 * finished, or if the edge of the path might have been crossed.
+	 */
+	double expectedChange(const Location &loc);
+};
+
+#endif        //  #ifndef RECHECKSCHEDULER_HPP
@@ -16,7 +16,11 @@
 #include "NetworkPage.hpp"
 #include "MenuPage.hpp"
 #include "SunPages.hpp"
+#include "Metrics.hpp"
+#include "PpsInput.hpp"
+#include "Trace.hpp"
 #include <filesystem>
+#include <cmath>
 
 extern std::atomic_bool quit;
 extern duds::ui::graphics::BppFontPool FontPool;
@@ -29,28 +33,42 @@ static const duds::os::linux::EventTypeCode EventLeft = { EV_KEY, BTN_DPAD_LEFT
 static const duds::os::linux::EventTypeCode EventRight = { EV_KEY, BTN_DPAD_RIGHT };
 
 RunUi::RunUi(
+	duds::os::linux::Poller &p,
 	duds::hardware::display::BppGraphicDisplaySptr &&gdisp,
 	duds::ui::graphics::BppImageArchiveSptr &&iarc,
 	const duds::hardware::devices::clocks::LinuxClockSptr &lcptr,
 	DisplayStuff &dstuff,
-	duds::hardware::interface::DigitalPin &buz
+	duds::hardware::interface::DigitalPin &buz,
+	const BesselianElements *be,
+	const SunEphemeris &eph,
+	const PpsInput *pp
 	//int toff
-) : disp(std::move(gdisp)), iconArc(std::move(iarc)), clock(lcptr), page(0),
-screen(iconArc, disp->dimensions()), displaystuff(dstuff), attn(lcptr, buz)
+) : disp(std::move(gdisp)), iconArc(std::move(iarc)), poller(p), clock(lcptr),
+pps(pp), frameTimer(p, std::bind(&RunUi::frame, this)),
+frameImg(disp->dimensions()), page(0), screen(iconArc, disp->dimensions()),
+displaystuff(dstuff), attn(p, lcptr, buz, pp)
 {
 	pages[Clock_Page] = std::make_unique<ClockPage>();
 	pages[GPS_Status] = std::make_unique<GpsPage>();
 	pages[Eclipse_Times] = std::make_unique<EclipsePage>();
 	pages[Totality_Times] = std::make_unique<TotalityPage>();
+	pages[Obscuration] = std::make_unique<ObscurationPage>(be);
 	pages[Schedule] = std::make_unique<SchedulePage>(
 		FontPool.getStringCache("Text"),
 		attn
 	);
-	pages[SunAz] = std::make_unique<SunAzPage>(lcptr);
-	pages[SunEl] = std::make_unique<SunElPage>(lcptr);
+	pages[SunAz] = std::make_unique<SunAzPage>(lcptr, eph, suntrack);
+	pages[SunEl] = std::make_unique<SunElPage>(lcptr, eph, suntrack);
+	pages[Sun_Clearance] = std::make_unique<HorizonPage>(
+		lcptr,
+		eph,
+		suntrack
+	);
 	pages[System] = std::make_unique<SystemPage>();
 	pages[Network] = std::make_unique<NetworkPage>();
 	pages[Sensors] = std::make_unique<SensorPage>();
+	pages[Timing] = std::make_unique<TimingPage>();
+	pages[Metrics] = std::make_unique<MetricsPage>();
 	pages[Menu] = std::make_unique<MenuPage>(
 		FontPool.getStringCache("Text"),
 		dstuff,
@@ -306,14 +324,13 @@ bool RunUi::initInput() {
 	return false;
 }
 
-void RunUi::run()
-try {
-	duds::ui::graphics::BppImage frame(disp->dimensions());
-	DisplayInfo dinfo;
+void RunUi::setHorizon(const Horizon *hor) {
+	static_cast<HorizonPage*>(pages[Sun_Clearance].get())->setHorizon(hor);
+}
+
+void RunUi::start() {
 	duds::data::Measurement::TimeSample time;
-	duds::data::Measurement::TimeSample::Value stime;
 	clock->sampleTime(time);
-	stime = time.value;
 	pageswitch = time.value + pagetime;
 	movePrev = inhand->connect(
 		EventLeft,
@@ -339,7 +356,7 @@ try {
 	blockNext = boost::signals2::shared_connection_block(moveNext, false);
 	rotor = inhand->connect(
 		EventDial,
-		[this, &dinfo](auto ig, auto val) {
+		[this](auto ig, auto val) {
 			if (val > 0) {
 				incPage(dinfo, Page::SelectUser, val);
 			} else {
@@ -357,68 +374,98 @@ try {
 		)
 	);
 	blockPin = boost::signals2::shared_connection_block(pagePin, false);
+	// show the result of any input right away
+	for (const duds::os::linux::EventTypeCode &etc : {
+		EventDial, EventSelect, EventUp, EventDown, EventLeft, EventRight
+	}) {
+		inhand->connect(
+			etc,
+			[this](auto ig, auto val) {
+				frameTimer.once(std::chrono::nanoseconds(0));
+			}
+		);
+	}
+	frame();
+}
+
+void RunUi::frame()
+try {
+	TRACE_SPAN("RunUi::frame");
+	duds::data::Measurement::TimeSample time;
 	// used to prevent page changes during critical times
-	bool pagechange = true;
-	// UI loop
-	do {
-		clock->sampleTime(time);
-		// advance time by 64ms (the display is slow)
-		time.value += duds::time::interstellar::Milliseconds(64);
-		displaystuff.setTime(
-			duds::time::planetary::earth->posix(
-				time.value
-			).time_of_day().total_seconds()
+	const bool pagechange = true;
+	clock->sampleTime(time);
+	// correct to the true second if measured
+	double ppsOff = 0;
+	if (pps && pps->offset(ppsOff)) {
+		time.value -= duds::time::interstellar::Nanoseconds(
+			std::llround(ppsOff * 1e9)
 		);
-		displaystuff.getInfo(dinfo);
-		if (dinfo.errormsg.empty()) {
-			screen.hideInfoMsg();
+	}
+	// advance time by 64ms (the display is slow)
+	time.value += duds::time::interstellar::Milliseconds(64);
+	displaystuff.setTime(
+		duds::time::planetary::earth->posix(
+			time.value
+		).time_of_day().total_seconds()
+	);
+	displaystuff.getInfo(dinfo);
+	if (dinfo.errormsg.empty()) {
+		screen.hideInfoMsg();
+	} else {
+		screen.showInfoMsg(dinfo.errormsg);
+	}
+	if (pagechange) {
+		// change on attention event
+		int chgp = attn.changeToPage();
+		if (chgp > 0) {
+			changePage(dinfo, Page::SelectUser, chgp);
+			if (!pagepinned) {
+				pageswitch = time.value + pagetime * 5;
+			}
 		} else {
-			screen.showInfoMsg(dinfo.errormsg);
-		}
-		if (pagechange) {
-			// change on attention event
-			int chgp = attn.changeToPage();
-			if (chgp > 0) {
-				changePage(dinfo, Page::SelectUser, chgp);
-				if (!pagepinned) {
-					pageswitch = time.value + pagetime * 5;
-				}
-			} else {
-				// auto page change
-				if (time.value > pageswitch) {
-					incPage(dinfo, Page::SelectAuto);
-					pageswitch = time.value + pagetime;
-				}
+			// auto page change
+			if (time.value > pageswitch) {
+				incPage(dinfo, Page::SelectAuto);
+				pageswitch = time.value + pagetime;
 			}
 		}
-		// update the displayed page
-		pages[page]->update(dinfo, &screen);
-		// show the time 64ms in the future; it'll take a while to update the
-		// display
-		screen.render(frame, time);
-		disp->write(&frame);
-		// wait on input until 60ms before the next second
-		if (
-			poller.wait(
-				std::max(
-					// delay to next second
+	}
+	// update the displayed page
+	pages[page]->update(dinfo, &screen);
+	// show the time 64ms in the future; it'll take a while to update the
+	// display
+	screen.render(frameImg, time);
+	{
+		TRACE_SPAN("display write");
+		auto start = std::chrono::steady_clock::now();
+		disp->write(&frameImg);
+		metrics.frameWriteTime.observe(
+			std::chrono::steady_clock::now() - start
+		);
+	}
+	metrics.framesRendered.inc();
+	// next update 60ms before the next second
+	frameTimer.once(
+		std::max(
+			// delay to next true second
+			duds::time::interstellar::Milliseconds(1000) -
+			(
+				(
+					duds::time::interstellar::MilliClock::now().time_since_epoch() +
 					duds::time::interstellar::Milliseconds(1000) -
-					(
-						duds::time::interstellar::MilliClock::now().time_since_epoch() %
-						duds::time::interstellar::Milliseconds(1000)
+					duds::time::interstellar::Milliseconds(
+						std::lround(ppsOff * 1000.0)
 					)
-					- duds::time::interstellar::Milliseconds(60),
-					// minimum delay; ensure not <= 0
-					duds::time::interstellar::Milliseconds(1)
-				)
-			) == poller.maxEvents
-		) {
-			// get more input
-			for (int limit = 8; limit && (poller.respond() == poller.maxEvents); --limit) { }
-		}
-	} while (!quit);
+				) % duds::time::interstellar::Milliseconds(1000)
+			)
+			- duds::time::interstellar::Milliseconds(60),
+			// minimum delay; ensure not <= 0
+			duds::time::interstellar::Milliseconds(1)
+		)
+	);
 } catch (...) {
-	std::cerr << "Program failed in RunUi::run():\n" <<
+	std::cerr << "Program failed in RunUi::frame():\n" <<
 	boost::current_exception_diagnostic_information() << std::endl;
 	quit = true;
 }
@@ -13,8 +13,15 @@
 #include <duds/os/linux/EvdevInput.hpp>
 #include <boost/signals2/shared_connection_block.hpp>
 #include "Attention.hpp"
+#include "Besselian.hpp"
 #include "Pages.hpp"
 #include "Screen.hpp"
+#include "SunEphemeris.hpp"
+#include "SunTrack.hpp"
+#include "TimerFd.hpp"
+
+class Horizon;
+class PpsInput;
 
 class RunUi : boost::noncopyable {
 	/**
@@ -26,9 +33,10 @@ class RunUi : boost::noncopyable {
 	duds::hardware::display::BppGraphicDisplaySptr disp;
 	duds::ui::graphics::BppImageArchiveSptr iconArc;
 	/**
-	 * Used to get input while waiting for it with epoll().
+	 * Used to get input and to time display updates along with everything
+	 * else in the program.
 	 */
-	duds::os::linux::Poller poller;
+	duds::os::linux::Poller &poller;
 	// need one per device
 	std::vector<duds::os::linux::EvdevInputSptr> evdevs;
 	// can be used with all EvdevInput objects, but same event code will call
@@ -39,6 +47,24 @@ class RunUi : boost::noncopyable {
 	 * The clock used to sample the current time.
 	 */
 	duds::hardware::devices::clocks::LinuxClockSptr clock;
+	/**
+	 * Optional correction for the clock's error; used so that the displayed
+	 * time and countdowns change on the true second.
+	 */
+	const PpsInput *pps;
+	/**
+	 * Wakes to update the display shortly before each second, or right
+	 * after input.
+	 */
+	TimerFd frameTimer;
+	/**
+	 * The image written to the display.
+	 */
+	duds::ui::graphics::BppImage frameImg;
+	/**
+	 * The information shown by the pages as of the last update.
+	 */
+	DisplayInfo dinfo;
 	/*
 	 * The sample of the current time.
 	 */
@@ -60,13 +86,17 @@ public:
 		GPS_Status,
 		Eclipse_Times,
 		Totality_Times,
+		Obscuration,
 		Sun_Azimuth,
 		Sun_Now,
 		Schedule,
 		SunAz,
 		SunEl,
+		Sun_Clearance,
 		System,
 		Sensors,
+		Timing,
+		Metrics,
 		Network,
 		Menu,
 		PageCycle         // if here, cycle to first page
@@ -76,6 +106,10 @@ private:
 	 * The page objects.
 	 */
 	std::unique_ptr<Page> pages[PageCycle];
+	/**
+	 * The sun's path during the eclipse; shared by the Sun pages.
+	 */
+	SunTrack suntrack;
 	Screen screen;
 	boost::signals2::connection movePrev, moveNext, rotor, pagePin;
 	boost::signals2::connection upKey, downKey, backKey, forwardKey, selectKey;
@@ -98,14 +132,23 @@ private:
 	void changePage(const DisplayInfo &di, Page::SelectionCause sc, int p);
 	void pinPage(int val);
 	void advancePageTime();
+	/**
+	 * Updates and writes out the display, then arms @a frameTimer for the
+	 * next update.
+	 */
+	void frame();
 
 public:
 	RunUi(
+		duds::os::linux::Poller &p,
 		duds::hardware::display::BppGraphicDisplaySptr &&gdisp,
 		duds::ui::graphics::BppImageArchiveSptr &&iarc,
 		const duds::hardware::devices::clocks::LinuxClockSptr &lcptr,
 		DisplayStuff &dstuff,
-		duds::hardware::interface::DigitalPin &buz
+		duds::hardware::interface::DigitalPin &buz,
+		const BesselianElements *be,
+		const SunEphemeris &eph,
+		const PpsInput *pp = nullptr
 		//int toff
 	);
 	/**
@@ -114,8 +157,15 @@ public:
 	 */
 	bool initInput();
 	/**
-	 * Runs the user interface thread; will not return until application
-	 * termination or unrecoverable error.
+	 * Provides the terrain for the sun clearance page. The terrain takes a
+	 * while to load, so it is given after the user interface has started.
+	 * Must be called from the thread running the Poller.
+	 * @param hor  The terrain; it must outlive this object.
+	 */
+	void setHorizon(const Horizon *hor);
+	/**
+	 * Connects the input handlers and shows the first frame. After this,
+	 * the user interface runs from the Poller given to the constructor.
 	 */
-	void run();
+	void start();
 };
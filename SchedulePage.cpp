@@ -166,7 +166,7 @@ void SchedulePage::show(const DisplayInfo &di, Screen *scr) {
 			view->jump(iter->second.index);
 		}		
 	} */
-	scr->showTitle("Schedule");
+	scr->showTitle(di.chkest ? "Schedule est." : "Schedule");
 	render.removeScrollBar();
 }
 
@@ -179,6 +179,10 @@ void SchedulePage::update(const DisplayInfo &di, Screen *scr) {
 	if (di.goodfix && di.totchg) {
 		makeEvents(di);
 	}
+	// mark times found from a dead reckoned position
+	if (di.chkchg) {
+		scr->showTitle(di.chkest ? "Schedule est." : "Schedule");
+	}
 	{
 		// update times
 		duds::ui::menu::MenuAccess acc(menu);
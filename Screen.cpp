@@ -11,6 +11,7 @@
  */
 #include <duds/ui/graphics/BppFontPool.hpp>
 #include "Screen.hpp"
+#include "Trace.hpp"
 
 extern duds::ui::graphics::BppFontPool FontPool;
 
@@ -158,6 +159,7 @@ void Screen::render(
 	duds::ui::graphics::BppImage &image,
 	const duds::data::Measurement::TimeSample &time
 ) {
+	TRACE_SPAN("Screen::render");
 	if (doLayout) {
 		// check for need to expand or collapse text fields
 		for (int r = 0; r < 3; ++r) {
@@ -0,0 +1,145 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "SensorWorker.hpp"
+#include "Metrics.hpp"
+#include "Trace.hpp"
+#include <boost/exception/diagnostic_information.hpp>
+#include <iostream>
+#include <mutex>
+
+constexpr std::chrono::seconds SensorDevice::minBackoff;
+constexpr std::chrono::seconds SensorDevice::maxBackoff;
+
+void SensorDevice::giveUp(Clock::time_point now) {
+	if (!reported) {
+		std::cerr << "ERROR: The " << nm << " cannot be used:\n" <<
+		boost::current_exception_diagnostic_information() << std::endl;
+		reported = true;
+	}
+	if (hlth.state == SensorHealth::Ready) {
+		close();
+		failed();
+	}
+	retry = now + backoff;
+	{
+		std::lock_guard<duds::general::Spinlock> lock(block);
+		hlth.state = SensorHealth::Backoff;
+		hlth.backoff = std::chrono::duration<double>(backoff).count();
+	}
+	backoff = std::min<Clock::duration>(backoff * 2, maxBackoff);
+}
+
+void SensorDevice::step() {
+	TRACE_SPAN("SensorDevice::step");
+	Clock::time_point now = Clock::now();
+	if (hlth.state == SensorHealth::Backoff) {
+		if (now < retry) {
+			return;
+		}
+		std::lock_guard<duds::general::Spinlock> lock(block);
+		hlth.state = SensorHealth::Closed;
+		hlth.backoff = 0;
+	}
+	if (hlth.state == SensorHealth::Closed) {
+		try {
+			open();
+		} catch (...) {
+			metrics.i2cErrors.inc();
+			{
+				std::lock_guard<duds::general::Spinlock> lock(block);
+				++hlth.errors;
+			}
+			// some of the device's objects may have been made
+			close();
+			giveUp(now);
+			return;
+		}
+		first = true;
+		std::lock_guard<duds::general::Spinlock> lock(block);
+		hlth.state = SensorHealth::Ready;
+		hlth.consecutive = 0;
+		++hlth.opens;
+		// the first sample is a period later; some devices need the time
+		return;
+	}
+	try {
+		sample(first);
+	} catch (...) {
+		bool limit;
+		metrics.i2cErrors.inc();
+		{
+			std::lock_guard<duds::general::Spinlock> lock(block);
+			++hlth.errors;
+			limit = ++hlth.consecutive >= failLimit;
+		}
+		if (limit) {
+			giveUp(now);
+		}
+		return;
+	}
+	if (reported) {
+		std::cerr << "The " << nm << " is working again." << std::endl;
+		reported = false;
+	}
+	first = false;
+	backoff = minBackoff;
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	++hlth.samples;
+	hlth.consecutive = 0;
+}
+
+SensorHealth SensorDevice::health() const {
+	std::lock_guard<duds::general::Spinlock> lock(block);
+	return hlth;
+}
+
+SensorWorker::SensorWorker() : tasks(poller), quit(false) { }
+
+SensorWorker::~SensorWorker() {
+	stop();
+}
+
+void SensorWorker::add(std::unique_ptr<SensorDevice> &&dev) {
+	SensorDevice *sd = dev.get();
+	devices.push_back(std::move(dev));
+	tasks.add(
+		sd->name(),
+		sd->period(),
+		std::chrono::milliseconds(100),
+		std::bind(&SensorDevice::step, sd)
+	);
+}
+
+void SensorWorker::start() {
+	thread = std::thread(&SensorWorker::run, this);
+}
+
+void SensorWorker::stop() {
+	quit = true;
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+void SensorWorker::run()
+try {
+	TRACE_THREAD("sensors");
+	while (!quit) {
+		// the timeout limits how long it takes to notice a stop request
+		if (poller.wait(250) == poller.maxEvents) {
+			for (int limit = 8; limit && (poller.respond() == poller.maxEvents); --limit) { }
+		}
+	}
+} catch (...) {
+	std::cerr << "Sensor worker failed:\n" <<
+	boost::current_exception_diagnostic_information() << std::endl;
+}
@@ -0,0 +1,212 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef SENSORWORKER_HPP
+#define SENSORWORKER_HPP
+
+#include <duds/general/Spinlock.hpp>
+#include "TaskWheel.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+
+/**
+ * The health of a sensor as tracked by SensorDevice.
+ */
+struct SensorHealth {
+	enum State {
+		/**
+		 * The device has not been opened, or is about to be reopened.
+		 */
+		Closed,
+		/**
+		 * The device is open and being sampled.
+		 */
+		Ready,
+		/**
+		 * The device failed and is closed until a retry time.
+		 */
+		Backoff
+	};
+	State state = Closed;
+	/**
+	 * Successful samples.
+	 */
+	unsigned long samples = 0;
+	/**
+	 * Failed attempts to open or sample the device.
+	 */
+	unsigned long errors = 0;
+	/**
+	 * Times the device was successfully opened.
+	 */
+	unsigned long opens = 0;
+	/**
+	 * Sampling failures since the last success.
+	 */
+	unsigned int consecutive = 0;
+	/**
+	 * The time until the next attempt to open the device in seconds; zero
+	 * unless in the Backoff state.
+	 */
+	double backoff = 0;
+};
+
+/**
+ * A sensor sampled by SensorWorker. The device is opened, sampled, and if it
+ * fails enough times in a row, closed and left alone for a while before
+ * being opened again. The time left alone starts at minBackoff and doubles
+ * with each failure that follows to at most maxBackoff; a good sample
+ * resets it. A device that cannot be opened is treated the same way, so a
+ * sensor that is missing at startup is picked up if it shows up later.
+ *
+ * The derived class does the work of opening, sampling and closing, and
+ * publishes the results, usually to DisplayStuff.
+ * @author  Jeff Jackowski
+ */
+class SensorDevice : boost::noncopyable {
+public:
+	typedef std::chrono::steady_clock  Clock;
+	static constexpr std::chrono::seconds minBackoff = std::chrono::seconds(2);
+	static constexpr std::chrono::seconds maxBackoff = std::chrono::seconds(128);
+private:
+	std::string nm;
+	std::chrono::milliseconds per;
+	/**
+	 * The number of sampling failures in a row that will close the device.
+	 */
+	unsigned int failLimit;
+	/**
+	 * Only modified by the worker thread; read by others under @a block.
+	 */
+	SensorHealth hlth;
+	mutable duds::general::Spinlock block;
+	Clock::time_point retry;
+	Clock::duration backoff = minBackoff;
+	/**
+	 * True until the next sample after opening.
+	 */
+	bool first = false;
+	/**
+	 * True once a failure has been reported so that it isn't repeated with
+	 * each retry.
+	 */
+	bool reported = false;
+	/**
+	 * Closes the device and waits before trying again. Must be called from
+	 * a catch block.
+	 */
+	void giveUp(Clock::time_point now);
+protected:
+	/**
+	 * Opens and initializes the device.
+	 * @throw anything  The device cannot be used.
+	 */
+	virtual void open() = 0;
+	/**
+	 * Samples the device and publishes the results.
+	 * @param first  True for the first sample after opening; useful for
+	 *               initializing averages.
+	 * @throw anything  The sample failed.
+	 */
+	virtual void sample(bool first) = 0;
+	/**
+	 * Releases the device; must not throw.
+	 */
+	virtual void close() = 0;
+	/**
+	 * Called after the device is closed for failing; must not throw.
+	 */
+	virtual void failed() { }
+public:
+	/**
+	 * @param name    The name of the sensor used in reporting.
+	 * @param period  The time between samples.
+	 * @param limit   The number of sampling failures in a row that will
+	 *                close the device.
+	 */
+	SensorDevice(
+		const std::string &name,
+		std::chrono::milliseconds period,
+		unsigned int limit = 3
+	) : nm(name), per(period), failLimit(limit) { }
+	virtual ~SensorDevice() = default;
+	/**
+	 * Advances the device's state; called once per period by the worker.
+	 */
+	void step();
+	/**
+	 * Returns a copy of the device's health; may be called from any thread.
+	 */
+	SensorHealth health() const;
+	const std::string &name() const {
+		return nm;
+	}
+	std::chrono::milliseconds period() const {
+		return per;
+	}
+};
+
+/**
+ * Samples sensors on a thread of its own, so that slow or failing devices,
+ * and the I2C transactions in general, never hold up GPS handling, the user
+ * interface, or startup. The devices are sampled by periodic tasks on a
+ * TaskWheel driven by the worker's own Poller.
+ * @author  Jeff Jackowski
+ */
+class SensorWorker : boost::noncopyable {
+	duds::os::linux::Poller poller;
+	TaskWheel tasks;
+	std::vector<std::unique_ptr<SensorDevice> > devices;
+	std::thread thread;
+	std::atomic_bool quit;
+	void run();
+public:
+	SensorWorker();
+	/**
+	 * Stops the worker.
+	 */
+	~SensorWorker();
+	/**
+	 * Adds a device to sample; must be called before start(). The device
+	 * will be opened one period after starting.
+	 */
+	void add(std::unique_ptr<SensorDevice> &&dev);
+	/**
+	 * Starts the worker thread.
+	 */
+	void start();
+	/**
+	 * Stops the worker thread and waits for it to finish.
+	 */
+	void stop();
+	/**
+	 * The number of devices added.
+	 */
+	int size() const {
+		return (int)devices.size();
+	}
+	/**
+	 * Returns the device with the given index.
+	 */
+	const SensorDevice &device(int i) const {
+		return *devices[i];
+	}
+	/**
+	 * Returns the timing statistics of sampling the device with the given
+	 * index. Only call this after stop().
+	 */
+	const TaskStats &stats(int i) const {
+		return tasks.stats(i);
+	}
+};
+
+#endif        //  #ifndef SENSORWORKER_HPP
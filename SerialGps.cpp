@@ -0,0 +1,133 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "SerialGps.hpp"
+#include "Trace.hpp"
+#include <boost/throw_exception.hpp>
+#include <termios.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <ctime>
+
+/**
+ * Returns the termios speed for a baud rate, or zero if not supported.
+ */
+static speed_t baudSpeed(int baud) {
+	switch (baud) {
+		case 4800:
+			return B4800;
+		case 9600:
+			return B9600;
+		case 19200:
+			return B19200;
+		case 38400:
+			return B38400;
+		case 57600:
+			return B57600;
+		case 115200:
+			return B115200;
+		case 230400:
+			return B230400;
+		case 460800:
+			return B460800;
+	}
+	return 0;
+}
+
+SerialGps::SerialGps(
+	duds::os::linux::Poller &p,
+	const GpsFixHandler &h,
+	const std::string &device,
+	int b
+) : poller(p), parser(h), path(device), baud(b),
+timer(p, std::bind(&SerialGps::expired, this)) {
+	if (!baudSpeed(baud)) {
+		BOOST_THROW_EXCEPTION(SerialGpsBadBaud() << SerialGpsBaud(baud));
+	}
+	open();
+}
+
+SerialGps::~SerialGps() {
+	if (dev >= 0) {
+		poller.remove(dev);
+		::close(dev);
+	}
+}
+
+void SerialGps::open() {
+	dev = ::open(path.c_str(), O_RDONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+	if (dev < 0) {
+		timer.once(retryDelay);
+		return;
+	}
+	if (isatty(dev)) {
+		termios tio;
+		tcgetattr(dev, &tio);
+		cfmakeraw(&tio);
+		tio.c_cflag |= CLOCAL | CREAD;
+		cfsetispeed(&tio, baudSpeed(baud));
+		cfsetospeed(&tio, baudSpeed(baud));
+		tcsetattr(dev, TCSANOW, &tio);
+		// discard anything from before it was configured
+		tcflush(dev, TCIFLUSH);
+	}
+	parser.reset();
+	poller.add(this, dev, EPOLLIN);
+	timer.once(staleTime);
+}
+
+void SerialGps::close() {
+	if (dev >= 0) {
+		poller.remove(dev);
+		::close(dev);
+		dev = -1;
+	}
+	receiving = false;
+	timer.once(retryDelay);
+}
+
+void SerialGps::receive() {
+	char buf[512];
+	ssize_t len;
+	while ((len = read(dev, buf, sizeof(buf))) > 0) {
+		// timestamp as soon as possible after the data arrives
+		timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		receiving = true;
+		timer.once(staleTime);
+		parser.feed(
+			buf,
+			len,
+			(double)ts.tv_sec + (double)ts.tv_nsec * 1e-9
+		);
+	}
+	// end of file, as from a closed pty, or an error?
+	if ((len == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK))) {
+		close();
+	}
+}
+
+void SerialGps::expired() {
+	if (dev < 0) {
+		open();
+	} else {
+		// silent
+		close();
+	}
+}
+
+void SerialGps::respond(duds::os::linux::Poller *, int fd) {
+	TRACE_SPAN("SerialGps::respond");
+	if (fd == dev) {
+		receive();
+	}
+}
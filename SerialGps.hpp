@@ -0,0 +1,122 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef SERIALGPS_HPP
+#define SERIALGPS_HPP
+
+#include <boost/exception/info.hpp>
+#include "GpsParser.hpp"
+#include "GpsSource.hpp"
+#include "TimerFd.hpp"
+#include <chrono>
+#include <string>
+
+struct SerialGpsError : virtual std::exception, virtual boost::exception { };
+/**
+ * The requested baud rate is not supported.
+ */
+struct SerialGpsBadBaud : SerialGpsError { };
+typedef boost::error_info<struct Info_Baud, int>  SerialGpsBaud;
+
+/**
+ * Reads a GPS receiver's serial port directly, without gpsd. The data is
+ * parsed by GpsParser, which handles NMEA and u-blox UBX output. Each read
+ * is timestamped from the real-time clock as soon as it returns, so the
+ * arrival time of a fix is close to when its first byte arrived.
+ *
+ * The device is put into raw mode at the given baud rate if it is a
+ * terminal, which includes a pseudo-terminal for testing. The device and a
+ * timer are registered with a Poller. If the device cannot be opened,
+ * reports an error, or is silent for @a staleTime, it is closed and opened
+ * again after @a retryDelay. Recorded files cannot be used with epoll;
+ * GpsParser may be given their contents directly.
+ * @author  Jeff Jackowski
+ */
+class SerialGps : public GpsSource {
+	duds::os::linux::Poller &poller;
+	GpsParser parser;
+	std::string path;
+	int baud;
+	/**
+	 * The open device, or -1.
+	 */
+	int dev = -1;
+	/**
+	 * The timer for reopening and noticing silence.
+	 */
+	TimerFd timer;
+	/**
+	 * True once data has arrived since the device was opened.
+	 */
+	bool receiving = false;
+	/**
+	 * Opens the device again, or closes it after a silence.
+	 */
+	void expired();
+	/**
+	 * Opens and configures the device.
+	 */
+	void open();
+	/**
+	 * Closes the device and arms the timer to open it again.
+	 */
+	void close();
+	/**
+	 * Reads all available data and parses it.
+	 */
+	void receive();
+public:
+	/**
+	 * Time to wait after a failure before opening the device again.
+	 */
+	static constexpr std::chrono::milliseconds retryDelay =
+		std::chrono::milliseconds(2000);
+	/**
+	 * Time without any data before the device is presumed bad. Receivers
+	 * normally send output every second.
+	 */
+	static constexpr std::chrono::milliseconds staleTime =
+		std::chrono::milliseconds(10000);
+	/**
+	 * Makes the source and opens the device.
+	 * @param p     The Poller that will handle the file descriptors.
+	 * @param h     The function to call with each fix.
+	 * @param dev   The path to the serial device.
+	 * @param baud  The baud rate to use.
+	 * @throw TimerFdError      The timer could not be made.
+	 * @throw SerialGpsBadBaud  The baud rate is not supported.
+	 */
+	SerialGps(
+		duds::os::linux::Poller &p,
+		const GpsFixHandler &h,
+		const std::string &dev,
+		int baud = 9600
+	);
+	~SerialGps();
+	/**
+	 * True while data is arriving from the device.
+	 */
+	virtual bool connected() const {
+		return receiving;
+	}
+	/**
+	 * Returns counts of what has been parsed.
+	 */
+	const GpsParserStats &stats() const {
+		return parser.stats();
+	}
+	/**
+	 * Handles activity on the device; called by the Poller.
+	 */
+	virtual void respond(duds::os::linux::Poller *, int fd);
+};
+
+#endif        //  #ifndef SERIALGPS_HPP
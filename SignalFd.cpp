@@ -0,0 +1,49 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "SignalFd.hpp"
+#include <boost/exception/errinfo_errno.hpp>
+#include <boost/throw_exception.hpp>
+#include <sys/signalfd.h>
+#include <unistd.h>
+#include <cerrno>
+
+SignalFd::SignalFd(
+	duds::os::linux::Poller &p,
+	std::initializer_list<int> sigs,
+	const Handler &h
+) : poller(p), handler(h) {
+	sigset_t mask;
+	sigemptyset(&mask);
+	for (int s : sigs) {
+		sigaddset(&mask, s);
+	}
+	pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+	sigfd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	if (sigfd < 0) {
+		BOOST_THROW_EXCEPTION(SignalFdError() <<
+			boost::errinfo_errno(errno)
+		);
+	}
+	poller.add(this, sigfd);
+}
+
+SignalFd::~SignalFd() {
+	poller.remove(sigfd);
+	close(sigfd);
+}
+
+void SignalFd::respond(duds::os::linux::Poller *, int) {
+	signalfd_siginfo info;
+	while (read(sigfd, &info, sizeof(info)) == sizeof(info)) {
+		handler(info.ssi_signo);
+	}
+}
@@ -0,0 +1,59 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef SIGNALFD_HPP
+#define SIGNALFD_HPP
+
+#include <duds/os/linux/Poller.hpp>
+#include <boost/exception/info.hpp>
+#include <boost/noncopyable.hpp>
+#include <functional>
+#include <initializer_list>
+#include <csignal>
+
+struct SignalFdError : virtual std::exception, virtual boost::exception { };
+
+/**
+ * Receives signals through a signalfd registered with a Poller, so that
+ * they are handled along with everything else rather than interrupting
+ * whatever is running. The signals are blocked for the calling thread;
+ * this must be made before starting any threads so that they inherit the
+ * blocked signals, otherwise a signal could go to another thread.
+ * @author  Jeff Jackowski
+ */
+class SignalFd : public duds::os::linux::PollResponder, boost::noncopyable {
+public:
+	typedef std::function<void(int)>  Handler;
+private:
+	duds::os::linux::Poller &poller;
+	Handler handler;
+	int sigfd;
+public:
+	/**
+	 * Blocks the signals and starts receiving them.
+	 * @param p     The Poller that will handle the signals.
+	 * @param sigs  The signals to receive.
+	 * @param h     The function to call with each signal number.
+	 * @throw SignalFdError  The signalfd could not be made.
+	 */
+	SignalFd(
+		duds::os::linux::Poller &p,
+		std::initializer_list<int> sigs,
+		const Handler &h
+	);
+	~SignalFd();
+	/**
+	 * Calls the handler for each pending signal; used by the Poller.
+	 */
+	virtual void respond(duds::os::linux::Poller *, int);
+};
+
+#endif        //  #ifndef SIGNALFD_HPP
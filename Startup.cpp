@@ -0,0 +1,92 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "Startup.hpp"
+#include <boost/throw_exception.hpp>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+Startup::~Startup() {
+	for (auto &s : steps) {
+		s.second.wait();
+	}
+}
+
+void Startup::add(
+	const std::string &name,
+	std::initializer_list<std::string> deps,
+	const Step &step
+) {
+	if (steps.count(name)) {
+		BOOST_THROW_EXCEPTION(StartupDuplicateStep() <<
+			StartupStepName(name)
+		);
+	}
+	std::vector<std::shared_future<void> > waitOn;
+	for (const std::string &d : deps) {
+		auto iter = steps.find(d);
+		if (iter == steps.end()) {
+			BOOST_THROW_EXCEPTION(StartupUnknownStep() <<
+				StartupStepName(d)
+			);
+		}
+		waitOn.push_back(iter->second);
+	}
+	steps[name] = std::async(
+		std::launch::async,
+		[this, name, waitOn, step]() {
+			// rethrows a failure of a dependency
+			for (const std::shared_future<void> &f : waitOn) {
+				f.get();
+			}
+			step();
+			// one write so that lines from other threads don't get mixed in
+			std::ostringstream oss;
+			oss << "Startup: " << name << " done at " << elapsed() << "s\n";
+			std::cout << oss.str() << std::flush;
+		}
+	).share();
+}
+
+void Startup::wait(const std::string &name) const {
+	auto iter = steps.find(name);
+	if (iter == steps.end()) {
+		BOOST_THROW_EXCEPTION(StartupUnknownStep() << StartupStepName(name));
+	}
+	iter->second.get();
+}
+
+bool Startup::ready(const std::string &name) const {
+	auto iter = steps.find(name);
+	if (iter == steps.end()) {
+		BOOST_THROW_EXCEPTION(StartupUnknownStep() << StartupStepName(name));
+	}
+	if (
+		iter->second.wait_for(std::chrono::seconds(0)) ==
+		std::future_status::ready
+	) {
+		iter->second.get();
+		return true;
+	}
+	return false;
+}
+
+void Startup::check() const {
+	for (const auto &s : steps) {
+		if (
+			s.second.wait_for(std::chrono::seconds(0)) ==
+			std::future_status::ready
+		) {
+			s.second.get();
+		}
+	}
+}
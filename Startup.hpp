@@ -0,0 +1,96 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef STARTUP_HPP
+#define STARTUP_HPP
+
+#include <boost/exception/info.hpp>
+#include <boost/noncopyable.hpp>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <initializer_list>
+#include <map>
+#include <string>
+
+struct StartupError : virtual std::exception, virtual boost::exception { };
+/**
+ * A step was given a dependency that has not been added.
+ */
+struct StartupUnknownStep : StartupError { };
+/**
+ * A step was added with a name already in use.
+ */
+struct StartupDuplicateStep : StartupError { };
+
+typedef boost::error_info<struct Info_StepName, std::string>  StartupStepName;
+
+/**
+ * Runs the steps of bringing up the program concurrently, each on its own
+ * thread once the steps it depends on are done. A step's dependencies must
+ * be added before it, so there can be no cycles. If a step throws, the
+ * exception is rethrown from the steps that depend on it, and from wait(),
+ * ready() and check().
+ *
+ * The time each step finishes, measured from construction, is written to
+ * std::cout.
+ * @author  Jeff Jackowski
+ */
+class Startup : boost::noncopyable {
+	typedef std::chrono::steady_clock  Clock;
+	std::map<std::string, std::shared_future<void> > steps;
+	Clock::time_point begin;
+public:
+	typedef std::function<void()>  Step;
+	Startup() : begin(Clock::now()) { }
+	/**
+	 * Waits on all the steps to finish.
+	 */
+	~Startup();
+	/**
+	 * Starts a step.
+	 * @param name  The name of the step, used for dependencies and
+	 *              reporting.
+	 * @param deps  The names of steps that must finish first.
+	 * @param step  The function to run.
+	 * @throw StartupUnknownStep    A dependency has not been added.
+	 * @throw StartupDuplicateStep  The name is already used.
+	 */
+	void add(
+		const std::string &name,
+		std::initializer_list<std::string> deps,
+		const Step &step
+	);
+	/**
+	 * Waits on a step to finish.
+	 * @throw StartupUnknownStep  The step has not been added.
+	 * @throw anything            Whatever the step threw.
+	 */
+	void wait(const std::string &name) const;
+	/**
+	 * True if the step has finished; does not wait.
+	 * @throw StartupUnknownStep  The step has not been added.
+	 * @throw anything            Whatever the step threw.
+	 */
+	bool ready(const std::string &name) const;
+	/**
+	 * Rethrows the exception of any step that has failed; does not wait.
+	 */
+	void check() const;
+	/**
+	 * The time since construction in seconds.
+	 */
+	double elapsed() const {
+		return std::chrono::duration<double>(Clock::now() - begin).count();
+	}
+};
+
+#endif        //  #ifndef STARTUP_HPP
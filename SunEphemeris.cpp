@@ -0,0 +1,285 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "SunEphemeris.hpp"
+#include "Metrics.hpp"
+#include <duds/time/planetary/Planetary.hpp>
+#include <cmath>
+
+/**
+ * Evaluates a Chebyshev series at @a u, which must be in [-1, 1], using
+ * Clenshaw's recurrence.
+ */
+static double chebyshev(const double *c, double u) {
+	double b1 = 0, b2 = 0;
+	for (int j = SunEphemeris::order - 1; j > 0; --j) {
+		double b0 = 2.0 * u * b1 - b2 + c[j];
+		b2 = b1;
+		b1 = b0;
+	}
+	return u * b1 - b2 + c[0] * 0.5;
+}
+
+SunEphemeris::SunEphemeris(const boost::gregorian::date &first, int count) :
+days(count) {
+	duds::time::planetary::earth->date(startTime, first);
+	// Julian day at the start of the first day
+	double jd = (double)first.day_number() - 0.5;
+	double sd[order], cd[order], et[order];
+	for (Day &d : days) {
+		// sample at the Chebyshev nodes across the day
+		for (int k = 0; k < order; ++k) {
+			SunTerms st;
+			sunTerms(
+				st,
+				jd + 0.5 + 0.5 * std::cos(M_PI * ((double)k + 0.5) / order)
+			);
+			sd[k] = std::sin(st.decl);
+			cd[k] = std::cos(st.decl);
+			et[k] = st.eqtime;
+		}
+		// coefficients
+		for (int j = 0; j < order; ++j) {
+			d.sinDecl[j] = d.cosDecl[j] = d.eqtime[j] = 0;
+			for (int k = 0; k < order; ++k) {
+				double w = std::cos(M_PI * (double)j * ((double)k + 0.5) / order);
+				d.sinDecl[j] += sd[k] * w;
+				d.cosDecl[j] += cd[k] * w;
+				d.eqtime[j] += et[k] * w;
+			}
+			d.sinDecl[j] *= 2.0 / order;
+			d.cosDecl[j] *= 2.0 / order;
+			d.eqtime[j] *= 2.0 / order;
+		}
+		jd += 1.0;
+	}
+}
+
+const SunEphemeris::Day *SunEphemeris::find(
+	double &u,
+	double &dayFrac,
+	double secs
+) const {
+	if (secs < 0) {
+		return nullptr;
+	}
+	double day = secs / (60.0 * 60.0 * 24.0);
+	std::size_t idx = (std::size_t)day;
+	if (idx >= days.size()) {
+		return nullptr;
+	}
+	dayFrac = day - (double)idx;
+	u = dayFrac * 2.0 - 1.0;
+	return &(days[idx]);
+}
+
+bool SunEphemeris::cached(
+	const duds::time::interstellar::SecondTime &time
+) const {
+	double u, df;
+	return find(u, df, (double)(time - startTime).count()) != nullptr;
+}
+
+void SunEphemeris::terms(SunTerms &st, double &dayFrac, double secs) const {
+	double u;
+	const Day *d = find(u, dayFrac, secs);
+	if (!d) {
+		metrics.ephemerisMisses.inc();
+		sunTerms(st, time(secs));
+		double day = secs / (60.0 * 60.0 * 24.0);
+		dayFrac = day - std::floor(day);
+		return;
+	}
+	metrics.ephemerisHits.inc();
+	st.decl = std::atan2(chebyshev(d->sinDecl, u), chebyshev(d->cosDecl, u));
+	st.eqtime = chebyshev(d->eqtime, u);
+}
+
+/**
+ * Returns the hour angle in degrees within [-180, 180].
+ */
+static double hourAngle(const SunTerms &st, double dayFrac, const Location &loc) {
+	return std::remainder(
+		dayFrac * 360.0 + st.eqtime / 4.0 + loc.lon - 180.0,
+		360.0
+	);
+}
+
+double SunEphemeris::elevation(const Location &loc, double secs) const {
+	SunTerms st;
+	double df;
+	terms(st, df, secs);
+	double latrad = loc.lat * M_PI / 180.0;
+	return std::asin(std::sin(latrad) * std::sin(st.decl) + std::cos(latrad) *
+		std::cos(st.decl) * std::cos(hourAngle(st, df, loc) * M_PI / 180.0)
+	) * 180.0 / M_PI;
+}
+
+double SunEphemeris::transit(const Location &loc, double secs) const {
+	SunTerms st;
+	double df;
+	// The hour angle advances by a degree every 240 seconds plus a little
+	// from the change in the equation of time; the first step gets within a
+	// second or so, and the next makes up for the equation of time.
+	for (int i = 0; i < 3; ++i) {
+		terms(st, df, secs);
+		secs -= hourAngle(st, df, loc) * 240.0;
+	}
+	return secs;
+}
+
+double SunEphemeris::highest(const Location &loc, double secs) const {
+	for (int i = 0; i < 2; ++i) {
+		double e0 = elevation(loc, secs - 60.0);
+		double e1 = elevation(loc, secs);
+		double e2 = elevation(loc, secs + 60.0);
+		double curve = (e2 - 2.0 * e1 + e0) / 3600.0;
+		if (curve >= 0) {
+			break;
+		}
+		secs -= (e2 - e0) / 120.0 / curve;
+	}
+	return secs;
+}
+
+double SunEphemeris::refine(const Location &loc, double elev, double secs) const {
+	for (int i = 0; i < 2; ++i) {
+		double rate = (elevation(loc, secs + 30.0) - elevation(loc, secs - 30.0))
+			/ 60.0;
+		if (rate == 0) {
+			break;
+		}
+		secs -= (elevation(loc, secs) - elev) / rate;
+	}
+	return secs;
+}
+
+void SunEphemeris::terms(
+	SunTerms &st,
+	const duds::time::interstellar::SecondTime &time
+) const {
+	double df;
+	terms(st, df, seconds(time));
+}
+
+void SunEphemeris::position(
+	double &azimuth,
+	double &elevation,
+	const Location &loc,
+	const duds::time::interstellar::SecondTime &time
+) const {
+	double u, df;
+	const Day *d = find(u, df, (double)(time - startTime).count());
+	if (!d) {
+		sunPosition(azimuth, elevation, loc, time);
+		return;
+	}
+	double sd = chebyshev(d->sinDecl, u);
+	double cd = chebyshev(d->cosDecl, u);
+	double ha = (df * 360.0 + chebyshev(d->eqtime, u) / 4.0 + loc.lon - 180.0)
+		* M_PI / 180.0;
+	double latrad = loc.lat * M_PI / 180.0;
+	double sinLat = std::sin(latrad);
+	double cosLat = std::cos(latrad);
+	double ch = std::cos(ha);
+	elevation = std::asin(sinLat * sd + cosLat * cd * ch) * 180.0 / M_PI;
+	azimuth = std::atan2(std::sin(ha), ch * sinLat - sd / cd * cosLat) *
+		180.0 / M_PI + 180.0;
+}
+
+double SunEphemeris::transit(
+	duds::time::interstellar::SecondTime &when,
+	const Location &loc,
+	const duds::time::interstellar::SecondTime &near
+) const {
+	double t = transit(loc, seconds(near));
+	when = time(t);
+	return elevation(loc, t);
+}
+
+double SunEphemeris::peak(
+	duds::time::interstellar::SecondTime &when,
+	const Location &loc,
+	const duds::time::interstellar::SecondTime &from,
+	const duds::time::interstellar::SecondTime &to
+) const {
+	double a = seconds(from), b = seconds(to);
+	// elevation only has a maximum near a transit, so check those and the ends
+	double best = a, bestel = elevation(loc, a);
+	double el = elevation(loc, b);
+	if (el > bestel) {
+		best = b;
+		bestel = el;
+	}
+	for (
+		double t = transit(loc, a);
+		t <= b;
+		t = transit(loc, t + 60.0 * 60.0 * 24.0)
+	) {
+		double h = highest(loc, t);
+		if ((h >= a) && (h <= b)) {
+			el = elevation(loc, h);
+			if (el > bestel) {
+				best = h;
+				bestel = el;
+			}
+		}
+	}
+	when = time(best);
+	return bestel;
+}
+
+bool SunEphemeris::crossing(
+	duds::time::interstellar::SecondTime &when,
+	bool &rising,
+	const Location &loc,
+	double elev,
+	const duds::time::interstellar::SecondTime &from,
+	const duds::time::interstellar::SecondTime &to
+) const {
+	double a = seconds(from), b = seconds(to);
+	double latrad = loc.lat * M_PI / 180.0;
+	// start with the transit before the span; its setting may be inside
+	double t = transit(loc, a);
+	if (t > a) {
+		t = transit(loc, t - 60.0 * 60.0 * 24.0);
+	}
+	for (
+		;
+		(t - 60.0 * 60.0 * 12.0) <= b;
+		t = transit(loc, t + 60.0 * 60.0 * 24.0)
+	) {
+		SunTerms st;
+		double df;
+		terms(st, df, t);
+		// hour angle where the sun is at the elevation
+		double cosH = (std::sin(elev * M_PI / 180.0) - std::sin(latrad) *
+			std::sin(st.decl)) / (std::cos(latrad) * std::cos(st.decl));
+		if ((cosH < -1.0) || (cosH > 1.0)) {
+			// the sun stays above or below the elevation all day
+			continue;
+		}
+		double h = std::acos(cosH) * 180.0 / M_PI * 240.0;
+		double rise = refine(loc, elev, t - h);
+		if ((rise >= a) && (rise <= b)) {
+			when = time(rise);
+			rising = true;
+			return true;
+		}
+		double set = refine(loc, elev, t + h);
+		if ((set >= a) && (set <= b)) {
+			when = time(set);
+			rising = false;
+			return true;
+		}
+	}
+	return false;
+}
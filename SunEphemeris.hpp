@@ -0,0 +1,169 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef SUNEPHEMERIS_HPP
+#define SUNEPHEMERIS_HPP
+
+#include <boost/date_time/gregorian/gregorian_types.hpp>
+#include <boost/noncopyable.hpp>
+#include "Functions.hpp"
+#include <vector>
+#include <cmath>
+
+/**
+ * A cache of the slowly changing terms of the sun's position over a few days
+ * around an eclipse. Each day is fit with Chebyshev polynomials for the sine
+ * and cosine of the declination and for the equation of time, so finding the
+ * sun's position only takes a few multiply-adds along with the trig functions
+ * for the hour angle and the results. Outside of the cached days, the results
+ * come from sunPosition() and sunTerms() instead.
+ *
+ * The fits are made from the same NOAA spreadsheet computations used by
+ * sunPosition(); tools/ephemeris_report.cpp measures how well they agree.
+ * @author  Jeff Jackowski
+ */
+class SunEphemeris : boost::noncopyable {
+public:
+	/**
+	 * The number of Chebyshev coefficients used for each day.
+	 */
+	static constexpr int order = 6;
+private:
+	/**
+	 * The fits for one day.
+	 */
+	struct Day {
+		double sinDecl[order];
+		double cosDecl[order];
+		double eqtime[order];
+	};
+	std::vector<Day> days;
+	/**
+	 * Start of the first cached day.
+	 */
+	duds::time::interstellar::SecondTime startTime;
+	/**
+	 * Finds the day and the position within it, scaled to [-1, 1], for the
+	 * given time.
+	 * @return  The day, or nullptr if the time is not cached.
+	 */
+	const Day *find(double &u, double &dayFrac, double secs) const;
+	/**
+	 * Provides the declination, equation of time, and fraction of the day
+	 * for a time given as seconds from @a startTime. Uses sunTerms() if the
+	 * time is not cached.
+	 */
+	void terms(SunTerms &st, double &dayFrac, double secs) const;
+	/**
+	 * Returns the sun's elevation in degrees at a time given as seconds from
+	 * @a startTime.
+	 */
+	double elevation(const Location &loc, double secs) const;
+	/**
+	 * Returns the time, as seconds from @a startTime, of the transit nearest
+	 * to the given time.
+	 */
+	double transit(const Location &loc, double secs) const;
+	/**
+	 * Refines the time of the highest elevation near a transit with Newton's
+	 * method. The change in declination moves it a few seconds from the
+	 * transit.
+	 */
+	double highest(const Location &loc, double secs) const;
+	/**
+	 * Refines the time of an elevation crossing with Newton's method.
+	 */
+	double refine(const Location &loc, double elev, double secs) const;
+	double seconds(const duds::time::interstellar::SecondTime &time) const {
+		return (double)(time - startTime).count();
+	}
+	duds::time::interstellar::SecondTime time(double secs) const {
+		return startTime + duds::time::interstellar::Seconds(std::lround(secs));
+	}
+public:
+	/**
+	 * Makes the fits for @a count days starting with @a first.
+	 */
+	SunEphemeris(const boost::gregorian::date &first, int count);
+	/**
+	 * True if the time is within the cached days.
+	 */
+	bool cached(const duds::time::interstellar::SecondTime &time) const;
+	/**
+	 * Provides the declination and equation of time.
+	 */
+	void terms(
+		SunTerms &st,
+		const duds::time::interstellar::SecondTime &time
+	) const;
+	/**
+	 * Computes the azimuth and elevation of the sun in degrees. The azimuth is
+	 * measured clockwise from north.
+	 */
+	void position(
+		double &azimuth,
+		double &elevation,
+		const Location &loc,
+		const duds::time::interstellar::SecondTime &time
+	) const;
+	/**
+	 * Finds the sun's transit, or solar noon, nearest to the given time. The
+	 * hour angle is found from the equation of time and then refined, so the
+	 * result is good to the second without sampling the sun's position.
+	 * @param when  The time of the transit.
+	 * @param loc   The location on Earth.
+	 * @param near  A time within 12 hours of the transit.
+	 * @return      The elevation at transit in degrees.
+	 */
+	double transit(
+		duds::time::interstellar::SecondTime &when,
+		const Location &loc,
+		const duds::time::interstellar::SecondTime &near
+	) const;
+	/**
+	 * Finds the highest elevation of the sun within a span of time. That is
+	 * either a transit inside the span or one of its ends.
+	 * @param when  The time of the highest elevation.
+	 * @param loc   The location on Earth.
+	 * @param from  The start of the span.
+	 * @param to    The end of the span.
+	 * @return      The highest elevation in degrees.
+	 */
+	double peak(
+		duds::time::interstellar::SecondTime &when,
+		const Location &loc,
+		const duds::time::interstellar::SecondTime &from,
+		const duds::time::interstellar::SecondTime &to
+	) const;
+	/**
+	 * Finds the first time within a span that the sun crosses the given
+	 * elevation, such as rising above nearby trees. The hour angle of the
+	 * crossing is computed from the declination and then refined with a
+	 * couple of Newton steps.
+	 * @param when    The time of the crossing.
+	 * @param rising  True if the sun is rising through the elevation.
+	 * @param loc     The location on Earth.
+	 * @param elev    The elevation to cross in degrees.
+	 * @param from    The start of the span.
+	 * @param to      The end of the span.
+	 * @return        True if a crossing was found.
+	 */
+	bool crossing(
+		duds::time::interstellar::SecondTime &when,
+		bool &rising,
+		const Location &loc,
+		double elev,
+		const duds::time::interstellar::SecondTime &from,
+		const duds::time::interstellar::SecondTime &to
+	) const;
+};
+
+#endif        //  #ifndef SUNEPHEMERIS_HPP
@@ -10,7 +10,10 @@
  * Copyright (C) 2024  Jeff Jackowski
  */
 #include "SunPages.hpp"
+#include "Horizon.hpp"
 #include "Screen.hpp"
+#include <algorithm>
+#include <cmath>
 
 Page::SelectionResponse SunAzPage::select(
 	const DisplayInfo &di,
@@ -37,53 +40,36 @@ void SunAzPage::show(const DisplayInfo &di, Screen *scr) {
 }
 
 void SunAzPage::update(const DisplayInfo &di, Screen *scr) {
-	// limit recomputations
+	// limit display changes
 	if (--rcnt < 0) {
 		rcnt = 8;
 		duds::data::Measurement::TimeSample ts;
 		double naz, nel, taz, tel, saz, eaz, el;
 		int midt = (di.end - di.start) / 2 + di.start;
 		clock->sampleTime(ts);
+		track.update(di, ts.value);
 		// current position
-		sunPosition(naz, nel, di.curloc, ts.value);
+		if (!track.position(naz, nel, ts.value)) {
+			ephemeris.position(naz, nel, di.curloc, ts.value);
+		}
 		std::ostringstream oss;
 		oss << std::fixed << std::setprecision(0) << naz;
 		scr->showText(oss.str(), 1, 0);
 		// inside totality?
-		if (di.inTotality) {
+		if (track.tracking()) {
 			// position at mid-totality
-			sunPosition(
-				taz,
-				tel,
-				di.curloc,
-				ts.value + duds::time::interstellar::Seconds(midt - di.now)
-			);
-			// position at eclipse start
-			sunPosition(
-				saz,
-				el,
-				di.curloc,
-				ts.value + duds::time::interstellar::Seconds(
-					di.start - DisplayInfo::beforeTotality - di.now
-				)
-			);
-			// position at eclipse end
-			sunPosition(
-				eaz,
-				el,
-				di.curloc,
-				ts.value + duds::time::interstellar::Seconds(
-					di.end + DisplayInfo::afterTotality - di.now
-				)
-			);
+			track.position(taz, tel, midt);
+			// positions at eclipse start and end
+			track.front(saz, el);
+			track.back(eaz, el);
 			oss.str(std::string());
 			oss << taz;
 			scr->showText(oss.str(), 1, 1);
 			oss.str(std::string());
-			oss << (taz - naz);
+			oss << std::remainder(taz - naz, 360.0);
 			scr->showText(oss.str(), 1, 2);
 			oss.str(std::string());
-			oss << std::fabs(eaz - saz);
+			oss << std::fabs(std::remainder(eaz - saz, 360.0));
 			scr->showText(oss.str(), 3, 2);
 		} else {
 			scr->showText("N/A", 1, 1);
@@ -122,43 +108,37 @@ void SunElPage::show(const DisplayInfo &di, Screen *scr) {
 }
 
 void SunElPage::update(const DisplayInfo &di, Screen *scr) {
-	// limit recomputations
+	// limit display changes
 	if (--rcnt < 0) {
 		rcnt = 8;
 		duds::data::Measurement::TimeSample ts;
-		double az, nel, el;
+		double az, nel;
 		clock->sampleTime(ts);
+		track.update(di, ts.value);
 		// current position
-		sunPosition(az, nel, di.curloc, ts.value);
+		if (!track.position(az, nel, ts.value)) {
+			ephemeris.position(az, nel, di.curloc, ts.value);
+		}
 		std::ostringstream oss;
 		oss << std::fixed << std::setprecision(0) << nel;
 		scr->showText(oss.str(), 1, 0);
-		if (di.inTotality) {
-			int newmidt = (di.end - di.start) / 2 + di.start;
-			if ((newmidt != midt) || di.totchg || di.poschg) {
-				midt = newmidt;
+		if (track.tracking()) {
+			if (track.revision() != trackrev) {
+				trackrev = track.revision();
 				// position at mid-totality
-				sunPosition(
-					az,
-					tel,
-					di.curloc,
-					ts.value + duds::time::interstellar::Seconds(midt - di.now)
-				);
+				track.position(az, tel, (di.end - di.start) / 2 + di.start);
 				// find peak
-				duds::time::interstellar::SecondTime chkt =
+				duds::time::interstellar::SecondTime peakt;
+				peak = std::max(0.0, ephemeris.peak(
+					peakt,
+					di.curloc,
 					ts.value + duds::time::interstellar::Seconds(
 						di.start - DisplayInfo::beforeTotality - di.now
-					);
-				duds::time::interstellar::SecondTime endt =
+					),
 					ts.value + duds::time::interstellar::Seconds(
 						di.end + DisplayInfo::afterTotality - di.now
-					);
-				peak = 0;
-				do {
-					sunPosition(az, el, di.curloc, chkt);
-					peak = std::max(peak, el);
-					chkt += duds::time::interstellar::Seconds(64);
-				} while (chkt < endt);
+					)
+				));
 			}
 			oss.str(std::string());
 			oss << tel;
@@ -176,3 +156,75 @@ void SunElPage::update(const DisplayInfo &di, Screen *scr) {
 void SunElPage::hide(const DisplayInfo &di, Screen *scr) {
 	scr->hideText();
 }
+
+
+Page::SelectionResponse HorizonPage::select(
+	const DisplayInfo &di,
+	SelectionCause sc
+) {
+	if (horizon && di.goodfix && di.inTotality && (
+		(sc == SelectUser) ||
+		// don't auto-show during the eclipse
+		(di.now < (di.start - DisplayInfo::beforeTotality)) ||
+		(di.now > (di.end + DisplayInfo::afterTotality))
+	)) {
+		return SelectPage;
+	}
+	return SkipPage;
+}
+
+void HorizonPage::show(const DisplayInfo &di, Screen *scr) {
+	scr->showTitle("Sun Clearance");
+	scr->showText("C1", 0, 0);
+	scr->showText("C2", 2, 0);
+	scr->showText("C3", 0, 1);
+	scr->showText("C4", 2, 1);
+	scr->showText("Now", 0, 2);
+	rcnt = 0;
+}
+
+void HorizonPage::update(const DisplayInfo &di, Screen *scr) {
+	// limit display changes
+	if (--rcnt < 0) {
+		rcnt = 8;
+		duds::data::Measurement::TimeSample ts;
+		clock->sampleTime(ts);
+		track.update(di, ts.value);
+		// the terrain profile is computed along with the totality check, so
+		// it may lag behind a new location
+		if (!horizon->good() || !track.tracking()) {
+			scr->showText("N/A", 1, 0);
+			scr->showText("N/A", 3, 0);
+			scr->showText("N/A", 1, 1);
+			scr->showText("N/A", 3, 1);
+			scr->showText("N/A", 1, 2);
+			return;
+		}
+		const int contacts[4] = {
+			di.start - DisplayInfo::beforeTotality,
+			di.start,
+			di.end,
+			di.end + DisplayInfo::afterTotality
+		};
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(1);
+		double az, el;
+		for (int c = 0; c < 4; ++c) {
+			oss.str(std::string());
+			if (track.position(az, el, contacts[c])) {
+				oss << horizon->clearance(az, el);
+			} else {
+				oss << "N/A";
+			}
+			scr->showText(oss.str(), (c & 1) * 2 + 1, c / 2);
+		}
+		ephemeris.position(az, el, di.curloc, ts.value);
+		oss.str(std::string());
+		oss << horizon->clearance(az, el);
+		scr->showText(oss.str(), 1, 2);
+	}
+}
+
+void HorizonPage::hide(const DisplayInfo &di, Screen *scr) {
+	scr->hideText();
+}
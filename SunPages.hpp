@@ -11,16 +11,25 @@
  */
 #include <duds/hardware/devices/clocks/LinuxClock.hpp>
 #include "Page.hpp"
+#include "SunEphemeris.hpp"
+#include "SunTrack.hpp"
+
+class Horizon;
 
 /**
  * Sun azimuth page.
  */
 class SunAzPage : public Page {
 	duds::hardware::devices::clocks::LinuxClockSptr clock;
+	const SunEphemeris &ephemeris;
+	SunTrack &track;
 	int rcnt;
 public:
-	SunAzPage(const duds::hardware::devices::clocks::LinuxClockSptr &clk) :
-		clock(clk) { }
+	SunAzPage(
+		const duds::hardware::devices::clocks::LinuxClockSptr &clk,
+		const SunEphemeris &eph,
+		SunTrack &st
+	) : clock(clk), ephemeris(eph), track(st) { }
 	virtual SelectionResponse select(
 		const DisplayInfo &di,
 		SelectionCause cause
@@ -35,13 +44,52 @@ public:
  */
 class SunElPage : public Page {
 	duds::hardware::devices::clocks::LinuxClockSptr clock;
+	const SunEphemeris &ephemeris;
+	SunTrack &track;
 	double tel;
 	double peak;
-	int midt;
+	/**
+	 * The revision of the track used for @a tel and @a peak.
+	 */
+	unsigned int trackrev = 0;
+	int rcnt;
+public:
+	SunElPage(
+		const duds::hardware::devices::clocks::LinuxClockSptr &clk,
+		const SunEphemeris &eph,
+		SunTrack &st
+	) : clock(clk), ephemeris(eph), track(st) { }
+	virtual SelectionResponse select(
+		const DisplayInfo &di,
+		SelectionCause cause
+	);
+	virtual void show(const DisplayInfo &di, Screen *scr);
+	virtual void hide(const DisplayInfo &di, Screen *scr);
+	virtual void update(const DisplayInfo &di, Screen *scr);
+};
+
+/**
+ * Sun clearance above the terrain at each contact of the eclipse. Only
+ * available once a digital elevation model has been given with setHorizon().
+ */
+class HorizonPage : public Page {
+	duds::hardware::devices::clocks::LinuxClockSptr clock;
+	const SunEphemeris &ephemeris;
+	SunTrack &track;
+	const Horizon *horizon;
 	int rcnt;
 public:
-	SunElPage(const duds::hardware::devices::clocks::LinuxClockSptr &clk) :
-		clock(clk) { }
+	HorizonPage(
+		const duds::hardware::devices::clocks::LinuxClockSptr &clk,
+		const SunEphemeris &eph,
+		SunTrack &st
+	) : clock(clk), ephemeris(eph), track(st), horizon(nullptr) { }
+	/**
+	 * Provides the terrain once it is loaded. It must outlive this object.
+	 */
+	void setHorizon(const Horizon *hor) {
+		horizon = hor;
+	}
 	virtual SelectionResponse select(
 		const DisplayInfo &di,
 		SelectionCause cause
@@ -0,0 +1,89 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "SunTrack.hpp"
+#include "DisplayStuff.hpp"
+#include <cmath>
+
+bool SunTrack::update(
+	const DisplayInfo &di,
+	const duds::time::interstellar::SecondTime &now
+) {
+	if (!di.inTotality) {
+		valid = false;
+		return false;
+	}
+	if (
+		valid && (di.start == start) && (di.end == end) &&
+		(haversineEarth(loc, di.curloc) < threshold)
+	) {
+		return false;
+	}
+	loc = di.curloc;
+	start = di.start;
+	end = di.end;
+	int begin = start - DisplayInfo::beforeTotality;
+	first = now + duds::time::interstellar::Seconds(begin - di.now);
+	std::size_t count = (end + DisplayInfo::afterTotality - begin) / step + 2;
+	azimuth.resize(count);
+	elevation.resize(count);
+	sunPositions(
+		azimuth.data(),
+		elevation.data(),
+		loc,
+		first,
+		duds::time::interstellar::Seconds(step),
+		count
+	);
+	valid = true;
+	if (++rev == 0) {
+		rev = 1;
+	}
+	return true;
+}
+
+bool SunTrack::interpolate(double &az, double &el, double offset) const {
+	if (!valid || (offset < 0)) {
+		return false;
+	}
+	double pos = offset / (double)step;
+	std::size_t idx = (std::size_t)pos;
+	if (idx + 1 >= azimuth.size()) {
+		return false;
+	}
+	double frac = pos - (double)idx;
+	el = elevation[idx] + (elevation[idx + 1] - elevation[idx]) * frac;
+	// the azimuth may wrap around north
+	az = azimuth[idx] + std::remainder(azimuth[idx + 1] - azimuth[idx], 360.0) *
+		frac;
+	if (az < 0) {
+		az += 360.0;
+	} else if (az >= 360.0) {
+		az -= 360.0;
+	}
+	return true;
+}
+
+bool SunTrack::position(
+	double &az,
+	double &el,
+	const duds::time::interstellar::SecondTime &time
+) const {
+	return interpolate(az, el, (double)(time - first).count());
+}
+
+bool SunTrack::position(double &az, double &el, int time) const {
+	return interpolate(
+		az,
+		el,
+		(double)(time - start + DisplayInfo::beforeTotality)
+	);
+}
@@ -0,0 +1,130 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef SUNTRACK_HPP
+#define SUNTRACK_HPP
+
+#include <boost/noncopyable.hpp>
+#include "Functions.hpp"
+#include <vector>
+
+struct DisplayInfo;
+
+/**
+ * The path of the sun across the sky during the eclipse at one location.
+ * The azimuth and elevation are computed at regular intervals with
+ * sunPositions() and interpolated when read, so the Sun pages do no trig work
+ * of their own. The track is only recomputed when the eclipse times change or
+ * the location moves more than @a threshold.
+ * @author  Jeff Jackowski
+ */
+class SunTrack : boost::noncopyable {
+	/**
+	 * Azimuth values in degrees.
+	 */
+	std::vector<double> azimuth;
+	/**
+	 * Elevation values in degrees.
+	 */
+	std::vector<double> elevation;
+	/**
+	 * The location used for the current track.
+	 */
+	Location loc;
+	/**
+	 * The time of the first value.
+	 */
+	duds::time::interstellar::SecondTime first;
+	/**
+	 * Eclipse start and end, in seconds since midnight UTC, used for the
+	 * current track.
+	 */
+	int start, end;
+	/**
+	 * Incremented each time the track is recomputed.
+	 */
+	unsigned int rev = 0;
+	bool valid = false;
+	/**
+	 * Interpolates the position at the given number of seconds after
+	 * @a first.
+	 */
+	bool interpolate(double &az, double &el, double offset) const;
+public:
+	/**
+	 * Seconds between computed positions.
+	 */
+	static constexpr int step = 10;
+	/**
+	 * Distance in meters the location may move before the track is
+	 * recomputed. At a kilometer, the sun's position changes by about a
+	 * hundredth of a degree, so the track is still good for display.
+	 */
+	static constexpr double threshold = 1000.0;
+	/**
+	 * Recomputes the track if needed. The track covers the time from
+	 * DisplayInfo::beforeTotality before the start of totality to
+	 * DisplayInfo::afterTotality after the end. Nothing is tracked while
+	 * outside the path of totality.
+	 * @param di   The current information about the eclipse and location.
+	 * @param now  The current time; needed to relate the eclipse times in
+	 *             @a di to absolute time.
+	 * @return     True if the track was recomputed.
+	 */
+	bool update(
+		const DisplayInfo &di,
+		const duds::time::interstellar::SecondTime &now
+	);
+	/**
+	 * True if the track has positions.
+	 */
+	bool tracking() const {
+		return valid;
+	}
+	/**
+	 * Changes each time the track is recomputed so that users can tell when
+	 * values derived from the track need to be updated. Never zero.
+	 */
+	unsigned int revision() const {
+		return rev;
+	}
+	/**
+	 * Provides the interpolated position of the sun.
+	 * @return  False if the time is outside of the track.
+	 */
+	bool position(
+		double &az,
+		double &el,
+		const duds::time::interstellar::SecondTime &time
+	) const;
+	/**
+	 * Provides the interpolated position of the sun at a time given as seconds
+	 * since midnight UTC, like the times in DisplayInfo.
+	 * @return  False if the time is outside of the track.
+	 */
+	bool position(double &az, double &el, int time) const;
+	/**
+	 * The position at the start of the track.
+	 */
+	void front(double &az, double &el) const {
+		az = azimuth.front();
+		el = elevation.front();
+	}
+	/**
+	 * The position at the end of the track.
+	 */
+	void back(double &az, double &el) const {
+		az = azimuth.back();
+		el = elevation.back();
+	}
+};
+
+#endif        //  #ifndef SUNTRACK_HPP
@@ -0,0 +1,94 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "TaskWheel.hpp"
+#include <algorithm>
+
+TaskWheel::TaskWheel(
+	duds::os::linux::Poller &p,
+	std::chrono::milliseconds t
+) : timer(p, std::bind(&TaskWheel::advance, this)), start(Clock::now()),
+tick(t) {
+	timer.every(tick);
+}
+
+int TaskWheel::add(
+	const std::string &name,
+	std::chrono::milliseconds period,
+	std::chrono::milliseconds jitter,
+	const Task &task
+) {
+	Entry e;
+	e.task = task;
+	e.stats.name = name;
+	e.jitter = jitter;
+	e.period = std::max<std::uint64_t>(
+		(period + tick / 2) / tick,
+		1
+	);
+	// base the first run on the present time rather than the last tick
+	// processed, which could be a few ticks behind
+	std::uint64_t now = (Clock::now() - start) / tick;
+	e.due = std::max(now, current) + e.period;
+	int id = (int)entries.size();
+	entries.push_back(std::move(e));
+	slots[entries[id].due % slotCount].push_back(id);
+	return id;
+}
+
+void TaskWheel::run(int id, std::uint64_t t, std::uint64_t now) {
+	Entry &e = entries[id];
+	Clock::duration late = Clock::now() - (start + tick * t);
+	if (late > e.jitter) {
+		++e.stats.misses;
+	}
+	e.stats.worstLate = std::max(
+		e.stats.worstLate,
+		std::chrono::duration<double>(late).count()
+	);
+	++e.stats.runs;
+	e.task();
+	// keep the period exact, but skip any periods already past
+	e.due += e.period;
+	while (e.due <= now) {
+		++e.stats.misses;
+		e.due += e.period;
+	}
+	slots[e.due % slotCount].push_back(id);
+}
+
+void TaskWheel::advance() {
+	std::uint64_t now = (Clock::now() - start) / tick;
+	// no need to go around the wheel more than once; after one turn every
+	// slot has been checked against the present tick
+	if ((now - current) > slotCount) {
+		current = now - slotCount;
+	}
+	while (current < now) {
+		++current;
+		std::vector<int> &slot = slots[current % slotCount];
+		// move out the due tasks first; they may be put back in this slot
+		std::vector<int> due;
+		slot.erase(
+			std::remove_if(slot.begin(), slot.end(), [&](int id) {
+				if (entries[id].due <= now) {
+					due.push_back(id);
+					return true;
+				}
+				return false;
+			}),
+			slot.end()
+		);
+		for (int id : due) {
+			run(id, entries[id].due, now);
+		}
+	}
+}
@@ -0,0 +1,163 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef TASKWHEEL_HPP
+#define TASKWHEEL_HPP
+
+#include "TimerFd.hpp"
+#include <boost/noncopyable.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * Statistics on the runs of a periodic task.
+ */
+struct TaskStats {
+	/**
+	 * The name given to the task; used for reporting.
+	 */
+	std::string name;
+	/**
+	 * The number of times the task was run.
+	 */
+	unsigned long runs = 0;
+	/**
+	 * The number of deadlines missed. A run that starts later than the
+	 * jitter limit counts as one, and each period skipped entirely because
+	 * the task was late by more than its period counts as another.
+	 */
+	unsigned long misses = 0;
+	/**
+	 * The latest a run has started, in seconds.
+	 */
+	double worstLate = 0;
+};
+
+/**
+ * Runs tasks periodically off a single timer registered with a Poller. The
+ * tasks are kept on a timer wheel: an array of slots, one per tick, that the
+ * timer steps through. A task sits in the slot of the tick when it is next
+ * due, and when that slot comes around it is run only if its due tick has
+ * arrived, so periods longer than the wheel just stay put for more turns.
+ * Each task keeps an exact period from when it was added; running late does
+ * not push back later runs.
+ *
+ * If the ticks stop for a while, such as when a task blocks, the wheel catches
+ * up on all the ticks missed the next time it runs. A task that missed
+ * several periods runs once, and the skipped periods are counted as misses.
+ *
+ * Everything runs on the thread that handles the Poller; there is no
+ * locking.
+ * @author  Jeff Jackowski
+ */
+class TaskWheel : boost::noncopyable {
+public:
+	typedef std::function<void()>  Task;
+	typedef std::chrono::steady_clock  Clock;
+private:
+	/**
+	 * Number of slots in the wheel.
+	 */
+	static constexpr std::size_t slotCount = 64;
+	struct Entry {
+		Task task;
+		TaskStats stats;
+		/**
+		 * The allowed lateness before a run counts as a missed deadline.
+		 */
+		Clock::duration jitter;
+		/**
+		 * The period in ticks.
+		 */
+		std::uint64_t period;
+		/**
+		 * The tick when the task is next due.
+		 */
+		std::uint64_t due;
+	};
+	/**
+	 * All the tasks; the index is the task's identifier.
+	 */
+	std::vector<Entry> entries;
+	/**
+	 * The index of each task in the slot of its due tick.
+	 */
+	std::vector<int> slots[slotCount];
+	/**
+	 * Periodically expires to advance the wheel.
+	 */
+	TimerFd timer;
+	/**
+	 * Time of tick zero.
+	 */
+	Clock::time_point start;
+	/**
+	 * The duration of one tick.
+	 */
+	Clock::duration tick;
+	/**
+	 * The last tick processed.
+	 */
+	std::uint64_t current = 0;
+	/**
+	 * Processes all ticks that have elapsed since the last.
+	 */
+	void advance();
+	/**
+	 * Runs a task that is due on tick @a t and puts it in the slot of its
+	 * next due tick.
+	 */
+	void run(int id, std::uint64_t t, std::uint64_t now);
+public:
+	/**
+	 * Makes an empty wheel that starts turning right away.
+	 * @param p     The Poller that will handle the wheel's timer.
+	 * @param tick  The time between ticks. Task periods are rounded to a
+	 *              multiple of this time.
+	 */
+	TaskWheel(
+		duds::os::linux::Poller &p,
+		std::chrono::milliseconds tick = std::chrono::milliseconds(50)
+	);
+	/**
+	 * Adds a periodic task. It is first run one period from now.
+	 * @param name    A name for the task used in reporting.
+	 * @param period  The time between runs; at least one tick.
+	 * @param jitter  How late a run may start before it counts as a missed
+	 *                deadline.
+	 * @param task    The function to run.
+	 * @return        The task's identifier for use with stats().
+	 */
+	int add(
+		const std::string &name,
+		std::chrono::milliseconds period,
+		std::chrono::milliseconds jitter,
+		const Task &task
+	);
+	/**
+	 * The number of tasks added.
+	 */
+	int size() const {
+		return (int)entries.size();
+	}
+	/**
+	 * Returns the statistics on the runs of a task.
+	 * @param id  The identifier returned from add().
+	 */
+	const TaskStats &stats(int id) const {
+		return entries[id].stats;
+	}
+};
+
+#endif        //  #ifndef TASKWHEEL_HPP
@@ -0,0 +1,68 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "TimerFd.hpp"
+#include <boost/exception/errinfo_errno.hpp>
+#include <boost/throw_exception.hpp>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+
+TimerFd::TimerFd(duds::os::linux::Poller &p, const Handler &h) :
+poller(p), handler(h) {
+	timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (timer < 0) {
+		BOOST_THROW_EXCEPTION(TimerFdError() <<
+			boost::errinfo_errno(errno)
+		);
+	}
+	poller.add(this, timer);
+}
+
+TimerFd::~TimerFd() {
+	poller.remove(timer);
+	close(timer);
+}
+
+static timespec toTimespec(std::chrono::nanoseconds ns) {
+	timespec ts;
+	ts.tv_sec = ns.count() / 1000000000;
+	ts.tv_nsec = ns.count() % 1000000000;
+	return ts;
+}
+
+void TimerFd::set(
+	std::chrono::nanoseconds first,
+	std::chrono::nanoseconds period
+) {
+	itimerspec its;
+	// a zero time would disarm the timer
+	if (first.count() <= 0) {
+		first = std::chrono::nanoseconds(1);
+	}
+	its.it_value = toTimespec(first);
+	its.it_interval = toTimespec(period);
+	timerfd_settime(timer, 0, &its, nullptr);
+}
+
+void TimerFd::disarm() {
+	itimerspec its = { };
+	timerfd_settime(timer, 0, &its, nullptr);
+}
+
+void TimerFd::respond(duds::os::linux::Poller *, int) {
+	std::uint64_t expired;
+	// nothing to read if disarmed or rearmed since the poll
+	if (read(timer, &expired, sizeof(expired)) > 0) {
+		handler();
+	}
+}
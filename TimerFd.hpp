@@ -0,0 +1,79 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef TIMERFD_HPP
+#define TIMERFD_HPP
+
+#include <duds/os/linux/Poller.hpp>
+#include <boost/exception/info.hpp>
+#include <boost/noncopyable.hpp>
+#include <chrono>
+#include <functional>
+
+struct TimerFdError : virtual std::exception, virtual boost::exception { };
+
+/**
+ * A timerfd registered with a Poller that calls a function when it expires.
+ * The timer uses the monotonic clock, so changes to the system time do not
+ * disturb it. It may expire once or periodically; a periodic timer keeps
+ * its period regardless of how long the function takes, and the function
+ * is called only once if several periods went by unhandled.
+ * @author  Jeff Jackowski
+ */
+class TimerFd : public duds::os::linux::PollResponder, boost::noncopyable {
+public:
+	typedef std::function<void()>  Handler;
+private:
+	duds::os::linux::Poller &poller;
+	Handler handler;
+	int timer;
+	void set(std::chrono::nanoseconds first, std::chrono::nanoseconds period);
+public:
+	/**
+	 * Makes a disarmed timer.
+	 * @param p  The Poller that will handle the timer.
+	 * @param h  The function to call on expiration.
+	 * @throw TimerFdError  The timer could not be made.
+	 */
+	TimerFd(duds::os::linux::Poller &p, const Handler &h);
+	~TimerFd();
+	/**
+	 * Expires once after the given time. A time of zero or less expires as
+	 * soon as possible.
+	 */
+	template <class R, class P>
+	void once(const std::chrono::duration<R,P> &delay) {
+		set(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(delay),
+			std::chrono::nanoseconds(0)
+		);
+	}
+	/**
+	 * Expires repeatedly with the given period, starting one period from
+	 * now.
+	 */
+	template <class R, class P>
+	void every(const std::chrono::duration<R,P> &period) {
+		std::chrono::nanoseconds p =
+			std::chrono::duration_cast<std::chrono::nanoseconds>(period);
+		set(p, p);
+	}
+	/**
+	 * Stops the timer.
+	 */
+	void disarm();
+	/**
+	 * Calls the handler; used by the Poller.
+	 */
+	virtual void respond(duds::os::linux::Poller *, int);
+};
+
+#endif        //  #ifndef TIMERFD_HPP
@@ -0,0 +1,154 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "Trace.hpp"
+
+#ifdef ECLIPSE_TRACE
+
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+thread_local TraceRing *traceRing = nullptr;
+
+/**
+ * All the rings and thread names. The lock is only taken when a thread gets
+ * its ring, names itself, or for a dump.
+ */
+static std::mutex traceLock;
+static std::vector<std::unique_ptr<TraceRing> > traceRings;
+static std::map<std::uint32_t, std::string> traceNames;
+
+/**
+ * Gives up the thread's ring when the thread ends.
+ */
+struct TraceRingOwner {
+	~TraceRingOwner() {
+		if (traceRing) {
+			traceRing->inUse.store(false, std::memory_order_release);
+			traceRing = nullptr;
+		}
+	}
+};
+
+TraceRing *traceAcquireRing() {
+	static thread_local TraceRingOwner owner;
+	std::lock_guard<std::mutex> lock(traceLock);
+	TraceRing *ring = nullptr;
+	for (std::unique_ptr<TraceRing> &r : traceRings) {
+		if (!r->inUse.load(std::memory_order_acquire)) {
+			ring = r.get();
+			break;
+		}
+	}
+	if (!ring) {
+		traceRings.push_back(std::make_unique<TraceRing>());
+		ring = traceRings.back().get();
+		ring->head.store(0, std::memory_order_relaxed);
+	}
+	ring->inUse.store(true, std::memory_order_relaxed);
+	ring->tid = (std::uint32_t)syscall(SYS_gettid);
+	traceRing = ring;
+	// makes sure the owner is constructed so its destructor runs
+	(void)owner;
+	return ring;
+}
+
+void traceThreadName(const std::string &name) {
+	if (!traceRing) {
+		traceAcquireRing();
+	}
+	std::lock_guard<std::mutex> lock(traceLock);
+	traceNames[traceRing->tid] = name;
+}
+
+/**
+ * Writes a string as a JSON string.
+ */
+static void writeString(std::ostream &os, const char *str) {
+	os << '"';
+	for (; *str; ++str) {
+		if ((*str == '"') || (*str == '\\')) {
+			os << '\\';
+		}
+		os << *str;
+	}
+	os << '"';
+}
+
+/**
+ * Writes nanoseconds as microseconds, the unit of the trace format.
+ */
+static void writeMicro(std::ostream &os, std::int64_t ns) {
+	os << ns / 1000 << '.' << std::setw(3) << std::setfill('0') <<
+	ns % 1000;
+}
+
+bool traceDump(const std::string &path) {
+	std::ofstream os(path, std::ios::trunc);
+	if (!os) {
+		return false;
+	}
+	std::vector<TraceEvent> events;
+	std::lock_guard<std::mutex> lock(traceLock);
+	os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	bool first = true;
+	for (const auto &tn : traceNames) {
+		if (!first) {
+			os << ',';
+		}
+		first = false;
+		os << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" <<
+		tn.first << ",\"args\":{\"name\":";
+		writeString(os, tn.second.c_str());
+		os << "}}";
+	}
+	for (const std::unique_ptr<TraceRing> &r : traceRings) {
+		std::uint32_t end = r->head.load(std::memory_order_acquire);
+		std::uint32_t count = std::min(end, TraceRing::size);
+		events.clear();
+		for (std::uint32_t i = end - count; i != end; ++i) {
+			events.push_back(r->events[i & (TraceRing::size - 1)]);
+		}
+		// the owner may have overwritten the oldest spans while copying, and
+		// may be writing the slot after span now - 1 before publishing it;
+		// with a full ring, that slot held the oldest copied span
+		std::atomic_thread_fence(std::memory_order_acquire);
+		std::uint32_t now = r->head.load(std::memory_order_relaxed);
+		std::uint32_t reach = now + 1 - (end - count);
+		std::uint32_t lost = (reach > TraceRing::size) ?
+			std::min(reach - TraceRing::size, count) : 0;
+		for (std::uint32_t i = lost; i < count; ++i) {
+			const TraceEvent &e = events[i];
+			if (!first) {
+				os << ',';
+			}
+			first = false;
+			os << "\n{\"name\":";
+			writeString(os, e.name);
+			os << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.tid << ",\"ts\":";
+			writeMicro(os, e.start);
+			os << ",\"dur\":";
+			writeMicro(os, e.duration);
+			os << '}';
+		}
+	}
+	os << "\n]}\n";
+	return (bool)os;
+}
+
+#endif  // ECLIPSE_TRACE
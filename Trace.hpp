@@ -0,0 +1,166 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+/**
+ * @file Trace.hpp
+ * Records where time is spent. Spans are marked with TRACE_SPAN, which
+ * records the time from that point to the end of the enclosing scope.
+ * Each thread records into a ring buffer of its own without locking, and
+ * traceDump() writes the contents of all the rings as a Chrome trace event
+ * file that can be viewed with chrome://tracing or Perfetto.
+ *
+ * All of it is compiled in only when ECLIPSE_TRACE is defined, which the
+ * build does when the TRACE option is set. Otherwise the macros expand to
+ * nothing.
+ */
+
+#ifdef ECLIPSE_TRACE
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <time.h>
+
+/**
+ * A span of time spent by a thread.
+ */
+struct TraceEvent {
+	/**
+	 * Name of the span; must be a string literal or otherwise outlive the
+	 * trace.
+	 */
+	const char *name;
+	/**
+	 * Start time in nanoseconds from an arbitrary point.
+	 */
+	std::int64_t start;
+	/**
+	 * Duration in nanoseconds.
+	 */
+	std::int64_t duration;
+	/**
+	 * Kernel ID of the thread that recorded the span.
+	 */
+	std::uint32_t tid;
+};
+
+/**
+ * Holds the most recent spans of one thread. Only the owning thread writes
+ * to it. The count of spans written is stored with release semantics after
+ * each span, so a reader can tell which spans are complete, and by checking
+ * the count again after copying, which were overwritten while it copied.
+ * The copy is a deliberate data race with the owner: rather than locking
+ * out the thread being traced, the reader discards any span the owner may
+ * have been writing, including the one in the slot after the newest
+ * published span. Strictly, that race is undefined behavior in C++, but
+ * the discarded copies are never used.
+ * Rings are not freed; when a thread ends, its ring is kept with its spans
+ * and reused by a later thread.
+ */
+struct TraceRing {
+	/**
+	 * The number of spans kept; must be a power of two.
+	 */
+	static constexpr std::uint32_t size = 8192;
+	TraceEvent events[size];
+	/**
+	 * The number of spans ever written. It may wrap since the size evenly
+	 * divides its range.
+	 */
+	std::atomic<std::uint32_t> head;
+	/**
+	 * True while a thread owns the ring.
+	 */
+	std::atomic_bool inUse;
+	std::uint32_t tid;
+	void record(const char *name, std::int64_t start, std::int64_t dur) {
+		std::uint32_t h = head.load(std::memory_order_relaxed);
+		TraceEvent &e = events[h & (size - 1)];
+		e.name = name;
+		e.start = start;
+		e.duration = dur;
+		e.tid = tid;
+		head.store(h + 1, std::memory_order_release);
+	}
+};
+
+/**
+ * The calling thread's ring, or nullptr before its first span.
+ */
+extern thread_local TraceRing *traceRing;
+
+/**
+ * Gives the calling thread a ring.
+ */
+TraceRing *traceAcquireRing();
+
+/**
+ * The time used for spans in nanoseconds. The monotonic clock is used so
+ * that adjustments to the system time cannot distort the spans.
+ */
+inline std::int64_t traceNow() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (std::int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * Records the time from construction to destruction.
+ */
+class TraceSpan {
+	const char *name;
+	std::int64_t start;
+public:
+	TraceSpan(const char *n) : name(n), start(traceNow()) { }
+	~TraceSpan() {
+		std::int64_t end = traceNow();
+		TraceRing *ring = traceRing;
+		if (!ring) {
+			ring = traceAcquireRing();
+		}
+		ring->record(name, start, end - start);
+	}
+};
+
+/**
+ * Names the calling thread in the trace.
+ */
+void traceThreadName(const std::string &name);
+
+/**
+ * Writes all recorded spans to a file in the Chrome trace event format.
+ * Threads may keep recording while this runs.
+ * @return  True if the file was written.
+ */
+bool traceDump(const std::string &path);
+
+#define TRACE_CONCAT_IMPL(a, b)  a##b
+#define TRACE_CONCAT(a, b)  TRACE_CONCAT_IMPL(a, b)
+/**
+ * Records a span from here to the end of the scope.
+ */
+#define TRACE_SPAN(name)  TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+/**
+ * Names the calling thread in the trace.
+ */
+#define TRACE_THREAD(name)  traceThreadName(name)
+
+#else
+
+#define TRACE_SPAN(name)
+#define TRACE_THREAD(name)
+
+#endif  // ECLIPSE_TRACE
+
+#endif        //  #ifndef TRACE_HPP
@@ -11,33 +11,95 @@
  */
 #include "Umbra.hpp"
 #include "Functions.hpp"
+#include "Trace.hpp"
 #include <boost/exception/errinfo_file_name.hpp>
 
-Umbra::Umbra(const std::string &fname, bool v) : first(-1), last(-1), verbose(v) {
-	GDALAllRegister();
+Umbra::Umbra(
+	const std::string &fname,
+	bool v,
+	const std::string &layer
+) : first(-1), last(-1), elements(nullptr), startT(0), endT(0), verbose(v) {
 	dataset = GDALDatasetUPtr((GDALDataset*)GDALOpenEx(
 		fname.c_str(), GDAL_OF_VECTOR, nullptr, nullptr, nullptr
 	), GDALDatasetDeleter());
 	if (!dataset) {
 		BOOST_THROW_EXCEPTION(UmbraOpenError() << boost::errinfo_file_name(fname));
 	}
-	umbras = dataset->GetLayerByName("umbra_hi");
+	umbras = dataset->GetLayerByName(layer.c_str());
 	if (!umbras) {
 		BOOST_THROW_EXCEPTION(UmbraNoLayer() << boost::errinfo_file_name(fname)
-			<< UmbraLayerName("umbra_hi")
+			<< UmbraLayerName(layer)
 		);
 	}
 	featdef = umbras->GetLayerDefn();
 	total = umbras->GetFeatureCount();
+	// find the start of the data; used to seed searches
+	umbras->ResetReading();
+	OGRFeatureUPtr feature(umbras->GetNextFeature(), OGRFeatureDeleter());
+	if (!feature) {
+		BOOST_THROW_EXCEPTION(UmbraNoFeature() << boost::errinfo_file_name(fname)
+			<< UmbraFeatureIndex(0)
+		);
+	}
+	firstFid = feature->GetFID();
+	firstT = feature->GetFieldAsInteger(1);
+}
+
+GIntBig Umbra::seedIndex(int time) {
+	// the shapes should be one second apart
+	GIntBig idx = firstFid + time - firstT;
+	// allow for missing shapes; should take at most a couple of tries
+	for (int tries = 4; tries > 0; --tries) {
+		if (idx < firstFid) {
+			return firstFid;
+		} else if (idx >= (firstFid + total)) {
+			idx = firstFid + total - 1;
+		}
+		OGRFeatureUPtr feature(umbras->GetFeature(idx), OGRFeatureDeleter());
+		if (!feature) {
+			break;
+		}
+		int diff = feature->GetFieldAsInteger(1) - time;
+		// at or before the requested time?
+		if (diff <= 0) {
+			return idx;
+		}
+		idx -= diff;
+	}
+	// something isn't as expected; start from the begining
+	return firstFid;
 }
 
 bool Umbra::check(double lon, double lat) {
+	TRACE_SPAN("Umbra::check");
 	OGRPoint loc(lon, lat);
 	umbras->ResetReading();
 	OGRFeatureUPtr feature;
 	GIntBig start;
+	bool seeded = false;
+	++counts.checks;
+	if (elements) {
+		LocalCircumstances lc;
+		Besselian(*elements).local(lc, Location(lon, lat));
+		// far enough outside the path to not bother with the shapes?
+		if (lc.umbraDistance > rejectDistance) {
+			if (verbose) {
+				std::cout << "Outside path by about " <<
+				(int)(lc.umbraDistance * 6378.0) << "km" << std::endl;
+			}
+			first = last = -1;
+			startT = endT = 0;
+			++counts.rejected;
+			return false;
+		}
+		// start the search shortly before the predicted maximum eclipse
+		start = seedIndex((int)lc.max - seedLead);
+		umbras->SetNextByIndex(start - firstFid);
+		feature = OGRFeatureUPtr(umbras->GetNextFeature(), OGRFeatureDeleter());
+		seeded = true;
+	}
 	// found an intersection earlier?
-	if (first > 0) {
+	else if (first > 0) {
 		// This is an imperfect and messy attempt at optimizing the search
 		// without going in reverse while trying to assure a correct answer.
 		// It is much less effective than location comparisons using just the
@@ -73,6 +135,7 @@ bool Umbra::check(double lon, double lat) {
 	int  missed = 0;
 	bool foundFirst = false;
 	do {
+		++counts.features;
 		if (verbose) {
 			Hms time(feature->GetFieldAsInteger(1));
 			std::cout << "Checking ";
@@ -92,14 +155,15 @@ bool Umbra::check(double lon, double lat) {
 		// test the location against the umbra's shape
 		OGRGeometry *shadow = feature->GetGeometryRef();
 		if (shadow) { // should always be true
+			++counts.polygonTests;
 			if (loc.Within(shadow)) {
 				if (foundFirst) {
 					last = feature->GetFID();
 					endT = feature->GetFieldAsInteger(1);
 					missed = 0;
 				} else {
-					first = feature->GetFID();
-					startT = feature->GetFieldAsInteger(1);
+					first = last = feature->GetFID();
+					startT = endT = feature->GetFieldAsInteger(1);
 					foundFirst = true;
 				}
 			} else if (foundFirst) {
@@ -109,12 +173,17 @@ bool Umbra::check(double lon, double lat) {
 	} while ((missed < 4) && (feature = OGRFeatureUPtr(
 		umbras->GetNextFeature(), OGRFeatureDeleter()
 	)));
-	// didn't find shapes with the point, but did before?
-	if (!foundFirst && (first >= 0)) {
+	// didn't find shapes with the point, but did before? A seeded search
+	// covers every shape that could include the point, so it won't help.
+	if (!foundFirst && (first >= 0) && !seeded) {
 		// try again
 		first = last = -1;
 		return check(lon, lat);
-	} else if (foundFirst && verbose) {
+	} else if (!foundFirst) {
+		// forget the shapes and times of an earlier hit
+		first = last = -1;
+		startT = endT = 0;
+	} else if (verbose) {
 		Hms time(startT);
 		std::cout << "Totality: ";
 		time.writeTime(std::cout);
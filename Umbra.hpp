@@ -9,10 +9,14 @@
  *
  * Copyright (C) 2024  Jeff Jackowski
  */
+#ifndef UMBRA_HPP
+#define UMBRA_HPP
+
 #include <gdal/ogrsf_frmts.h>
 #include <memory>
 #include <boost/exception/info.hpp>
 #include <boost/utility.hpp>
+#include "Besselian.hpp"
 
 struct GDALDatasetDeleter {
 	void operator()(GDALDataset *ds) {
@@ -38,6 +42,28 @@ typedef boost::error_info<struct Info_LayerName, std::string>  UmbraLayerName;
 struct UmbraNoFeature : UmbraError { };
 typedef boost::error_info<struct Info_FeatureIndex, GIntBig>  UmbraFeatureIndex;
 
+/**
+ * Counts of the work done by Umbra::check(). Used for benchmarking.
+ */
+struct UmbraStats {
+	/**
+	 * Calls to Umbra::check(), including internal retries.
+	 */
+	unsigned long checks = 0;
+	/**
+	 * Checks answered by the Besselian element prefilter alone.
+	 */
+	unsigned long rejected = 0;
+	/**
+	 * Features read from the shapefile.
+	 */
+	unsigned long features = 0;
+	/**
+	 * Tests of the location against a shape's polygon.
+	 */
+	unsigned long polygonTests = 0;
+};
+
 /**
  * Processes umbra shapes from NASA to determine if a location will see the
  * total eclipse of August 21, 2017, and if so, when the total eclipse will
@@ -45,29 +71,91 @@ typedef boost::error_info<struct Info_FeatureIndex, GIntBig>  UmbraFeatureIndex;
  * start time may be as much as almost a second late, and the end time may be
  * as much as almost a second early. I'm new to using GIS software, so I'm not
  * sure how best to implement useful interpolation.
+ *
+ * When given to prefilter(), the Besselian elements of the eclipse are used
+ * before the shapes are consulted to find the approximate circumstances at
+ * the location. Locations well outside the path are rejected without looking
+ * at the shapes, and the search through the shapes starts a little before the
+ * predicted maximum eclipse.
  * @author  Jeff Jackowski
  */
 class Umbra : boost::noncopyable {
 	GDALDatasetUPtr dataset;
 	GIntBig total, first, last;
+	/**
+	 * The ID of the first feature in the layer.
+	 */
+	GIntBig firstFid;
 	OGRLayer *umbras;
 	OGRFeatureDefn *featdef;
+	/**
+	 * The elements used to prefilter checks, or nullptr to always search the
+	 * shapes.
+	 */
+	const BesselianElements *elements;
+	UmbraStats counts;
 	int startT, endT; // in seconds from start of day UTC -- same as in shapefile
+	/**
+	 * Time of the first shape in the layer.
+	 */
+	int firstT;
 	double poslon, poslat;
 	bool verbose;
+	/**
+	 * Finds the index of a shape at or a bit before the given time in
+	 * seconds from midnight UTC.
+	 */
+	GIntBig seedIndex(int time);
 public:
 	/**
+	 * Locations farther than this from the predicted edge of the umbra, in
+	 * Earth radii on the fundamental plane, are rejected without checking the
+	 * shapes. This is about 25km; the prediction is usually within a couple of
+	 * kilometers of the shapes.
+	 */
+	static constexpr double rejectDistance = 0.004;
+	/**
+	 * The number of seconds before the predicted maximum eclipse to start
+	 * searching the shapes. Half of the longest totality of 2024 is 134s.
+	 */
+	static constexpr int seedLead = 180;
+	/**
+	 * Opens the shapefile. GDALAllRegister() must be called first, and not
+	 * concurrently with this.
 	 * @param fname  The name of the shapefile with the umbra shapes. It
 	 *               should be umbra_hi.shp, but could include a more complete
 	 *               path. See https://svs.gsfc.nasa.gov/5073 for the files.
 	 * @param v      True for verbose output to stdout.
+	 * @param layer  The name of the layer with the umbra shapes.
 	 */
-	Umbra(const std::string &fname, bool v = false);
+	Umbra(
+		const std::string &fname,
+		bool v = false,
+		const std::string &layer = "umbra_hi"
+	);
 	/**
 	 * Finds if the given location is within any of the umbra shapes, and
 	 * returns true if it is.
 	 */
 	bool check(double lon, double lat);
+	/**
+	 * Changes the Besselian elements used to prefilter checks. They must
+	 * outlive this object and be for the same eclipse as the shapes. Use
+	 * nullptr to disable the prefilter, which is how the object starts.
+	 */
+	void prefilter(const BesselianElements *e) {
+		elements = e;
+	}
+	/**
+	 * Returns counts of the work done since construction or the last call to
+	 * resetStats().
+	 */
+	const UmbraStats &stats() const {
+		return counts;
+	}
+	void resetStats() {
+		counts = UmbraStats();
+	}
 	/**
 	 * In seconds from midnight, UTC, day of eclipse.
 	 */
@@ -81,3 +169,5 @@ public:
 		return endT;
 	}
 };
+
+#endif        //  #ifndef UMBRA_HPP
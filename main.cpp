@@ -21,13 +21,6 @@
 #include <duds/hardware/interface/linux/GpioDevPort.hpp>
 #include <duds/hardware/interface/PinConfiguration.hpp>
 #include <duds/hardware/devices/clocks/LinuxClock.hpp>
-#include <duds/hardware/devices/instruments/AM2320.hpp>
-#include <duds/hardware/devices/instruments/INA219.hpp>
-#include <duds/hardware/devices/instruments/TSL2591.hpp>
-#include <duds/hardware/interface/linux/DevSmbus.hpp>
-#include <duds/hardware/interface/SmbusErrors.hpp>
-#include <duds/hardware/interface/linux/DevI2c.hpp>
-#include <duds/hardware/interface/I2cErrors.hpp>
 #include <duds/hardware/interface/linux/SysPwm.hpp>
 #include <boost/property_tree/info_parser.hpp>
 #include <duds/ui/graphics/BppFontPool.hpp>
@@ -36,10 +29,26 @@
 #include <boost/exception/diagnostic_information.hpp>
 #include <boost/program_options.hpp>
 #include <boost/uuid/string_generator.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
 #include <future>
-#include <csignal>
-#include <libgpsmm.h>
+#include "ClockMonitor.hpp"
+#include "EclipseCatalog.hpp"
+#include "Geodesy.hpp"
+#include "GpsClient.hpp"
+#include "GpsReplay.hpp"
+#include "SerialGps.hpp"
+#include "SignalFd.hpp"
+#include "Startup.hpp"
+#include "Trace.hpp"
+#include "Horizon.hpp"
+#include "I2cSensors.hpp"
+#include "MetricsServer.hpp"
+#include "PositionFilter.hpp"
+#include "PpsInput.hpp"
+#include "RecheckScheduler.hpp"
 #include "RunUi.hpp"
+#include "SunEphemeris.hpp"
+#include "TaskWheel.hpp"
 #include "Umbra.hpp"
 
 /**
@@ -62,15 +71,30 @@ static DisplayStuff displaystuff;
 
 std::atomic_bool quit(false);
 
-void signalHandler(int) {
-	quit = true;
-}
-
-void check(Umbra &umbra, const Location &loc)
+void check(
+	Umbra &umbra,
+	Horizon *horizon,
+	RecheckScheduler &sched,
+	const Location &loc
+)
 try {
+	TRACE_THREAD("umbra check");
+	unsigned long rejected = umbra.stats().rejected;
+	auto start = std::chrono::steady_clock::now();
 	bool res = umbra.check(loc.lon, loc.lat);
+	metrics.umbraCheckTime.observe(std::chrono::steady_clock::now() - start);
+	metrics.umbraChecks.inc();
+	metrics.umbraPrefiltered.inc(umbra.stats().rejected - rejected);
 	displaystuff.updateTotality(umbra.startTime(), umbra.endTime(), res);
+	// terrain only matters inside the path
+	if (horizon && res) {
+		horizon->update(loc);
+	}
+	// the next check may start once this one is finished; the horizon update
+	// is part of it
+	sched.finished(loc, res, umbra.startTime(), umbra.endTime());
 } catch (...) {
+	sched.failed();
 	std::cerr << "Program failed in umbra check thread:\n" <<
 	boost::current_exception_diagnostic_information()
 	<< std::endl;
@@ -79,9 +103,15 @@ try {
 int main(int argc, char *argv[])
 try {
 	std::string fontpath, confpath, lcdname, shapepath, zonepath, i2cpath;
+	std::string catalogpath, dempath, serialpath, layer("umbra_hi");
+	std::string recordpath, replaypath, ppspath, clocklogpath, metricspath;
+	double replaySpeed = 1.0;
+#ifdef ECLIPSE_TRACE
+	std::string tracepath("eclipse-trace.json");
+#endif
 	std::string imgpath(argv[0]), extimgpath;
 	double tlon = 400.0, tlat = 400.0;
-	int dispW, dispH;
+	int dispW, dispH, baud = 9600;
 	bool uselcd = false;
 	{
 		int found = 0;
@@ -165,6 +195,72 @@ try {
 					default_value("../umbra_hi.shp"),
 				"Path to shapefile"
 			)
+			(
+				"catalog",
+				boost::program_options::value<std::string>(&catalogpath),
+				"Path to an eclipse catalog directory; picks the next eclipse and "
+				"overrides --shape"
+			)
+			(
+				"dem",
+				boost::program_options::value<std::string>(&dempath),
+				"Path to a digital elevation model, like a GeoTIFF file, for "
+				"finding if terrain blocks the sun"
+			)
+			(
+				"serial",
+				boost::program_options::value<std::string>(&serialpath),
+				"Read the GPS receiver from this serial device rather than "
+				"using gpsd"
+			)
+			(
+				"baud",
+				boost::program_options::value<int>(&baud)->default_value(baud),
+				"Baud rate for the serial GPS receiver"
+			)
+			(
+				"pps",
+				boost::program_options::value<std::string>(&ppspath),
+				"PPS device, like /dev/pps0, for the GPS's pulse-per-second "
+				"output; used to measure the system clock's error"
+			)
+			(
+				"clock-log",
+				boost::program_options::value<std::string>(&clocklogpath),
+				"Write the system clock's error according to NTP to this file "
+				"each second"
+			)
+			(
+				"record",
+				boost::program_options::value<std::string>(&recordpath),
+				"Record all GPS reports to this file"
+			)
+			(
+				"replay",
+				boost::program_options::value<std::string>(&replaypath),
+				"Play back GPS reports recorded with --record instead of using "
+				"a GPS; quits at the end of the recording"
+			)
+			(
+				"replay-speed",
+				boost::program_options::value<double>(&replaySpeed)->
+					default_value(replaySpeed),
+				"Speed factor for --replay; zero for as fast as possible"
+			)
+			(
+				"metrics",
+				boost::program_options::value<std::string>(&metricspath),
+				"Serve metrics in the Prometheus text format on this localhost "
+				"TCP port, or on a Unix socket at this path"
+			)
+#ifdef ECLIPSE_TRACE
+			(
+				"trace",
+				boost::program_options::value<std::string>(&tracepath)->
+					default_value(tracepath),
+				"Write the trace to this file on SIGUSR1"
+			)
+#endif
 			(
 				"zone,z",
 				boost::program_options::value<std::string>(&zonepath)->
@@ -199,195 +295,191 @@ try {
 			uselcd = true;
 		}
 	}
-	Umbra umbra(shapepath, tlon < 200.0);
-	// distant initial location helps ensure an early totality check
-	Location prev(0.0, 0.0), curr;
-	std::unique_ptr<gpsmm> gps;
-	// use test location?
-	if ((tlon < 200.0) || (tlat < 200.0)) {
-		// configure test data
-		displaystuff.setTesting();
-		curr = Location(tlon, tlat);
-		displaystuff.setCurrLoc(curr, 16, 8);
-		displaystuff.setCheckLoc(curr);
-		// start computing total eclipse length
-		/*
-		eclipseCalc = std::async(
-			std::launch::async,
-			&check,
-			std::ref(umbra),
-			std::ref(curr)
+	// pick the eclipse to use
+	std::unique_ptr<EclipseCatalog> catalog;
+	const BesselianElements *elements = &Eclipse20240408;
+	boost::gregorian::date eclipseDate(2024, boost::gregorian::Apr, 8);
+	if (!catalogpath.empty()) {
+		catalog = std::make_unique<EclipseCatalog>(catalogpath);
+		const EclipseEntry &ecl = catalog->select(
+			boost::gregorian::day_clock::universal_day()
 		);
-		*/
-		check(umbra, curr);
-		DisplayInfo di;
-		displaystuff.getInfo(di);
-		if (di.inTotality) {
-			std::cout << "In";
+		std::cout << "Using eclipse " << ecl.name << " on " <<
+		boost::gregorian::to_iso_extended_string(ecl.date) << std::endl;
+		shapepath = ecl.shape;
+		layer = ecl.layer;
+		eclipseDate = ecl.date;
+		DisplayInfo::beforeTotality = ecl.beforeTotality;
+		DisplayInfo::afterTotality = ecl.afterTotality;
+		if (ecl.haveElements) {
+			elements = &ecl.elements;
 		} else {
-			std::cout << "Out";
-		}
-		std::cout << "side area of totality." << std::endl;
-	} else {
-		// attempt to connect to GPSD
-		gps = std::make_unique<gpsmm>("localhost", DEFAULT_GPSD_PORT);
-		// failed?
-		if (!gps->stream(WATCH_ENABLE|WATCH_JSON)) {
-			gps.reset();
-			displaystuff.setError("No gpsd connection", 8);
+			elements = nullptr;
 		}
 	}
-	// signal handler
-	std::signal(SIGINT, &signalHandler);
-	std::signal(SIGTERM, &signalHandler);
-
-	// load fonts
-	FontPool.addWithCache("Date-small", extimgpath + "/font_Vx8.bppia");
-	FontPool.addWithCache("Date-medium", extimgpath + "/font_Vx8B.bppia");
-	//FontPool.addWithCache("Date-large", extimgpath + "/font_10x18.bppia");
-	//FontPool.addWithCache("Time-small", extimgpath + "/font_Vx7.bppia");
-	//FontPool.alias("Date-small", "Time-medium");
-	FontPool.alias("Date-small", "Time-tiny");
-	FontPool.alias("Date-medium", "Time-small");
-	FontPool.addWithCache("Time-medium", extimgpath + "/font_7x14.bppia");
-	FontPool.addWithCache("Time-large", imgpath + "/timefont_12x17.bppia");
-	FontPool.alias("Date-small", "Title");
-	//FontPool.alias("Date-medium", "Title");
-	FontPool.alias("Date-medium", "Text");
-	// load icons
-	duds::ui::graphics::BppImageArchiveSptr iconArc =
-		duds::ui::graphics::BppImageArchive::make(imgpath + "/icons.bppia");
+	Clock = duds::hardware::devices::clocks::LinuxClock::make();
+	// everything but the umbra checks runs from this poller
+	duds::os::linux::Poller poller;
+	// termination signals are handled by the poller; must be done before
+	// starting any threads
+	SignalFd signals(poller, { SIGINT, SIGTERM }, [](int) {
+		quit = true;
+	});
+#ifdef ECLIPSE_TRACE
+	TRACE_THREAD("main");
+	// write out the trace on request
+	SignalFd traceSignal(poller, { SIGUSR1 }, [&tracepath](int) {
+		if (traceDump(tracepath)) {
+			std::cout << "Wrote trace to " << tracepath << std::endl;
+		} else {
+			std::cerr << "ERROR: Cannot write trace to " << tracepath <<
+			std::endl;
+		}
+	});
+#endif
 
+	// filtered position; set from the GPS, or the test location
+	Location curr;
+	// decides when to check again based on how fast the contact times change
+	// around the last checked location
+	RecheckScheduler scheduler(elements);
+	// serves counters and timings for watching a running unit
+	std::unique_ptr<MetricsServer> metricsServer;
+	if (!metricspath.empty()) {
+		try {
+			metricsServer = std::make_unique<MetricsServer>(
+				poller, metrics, metricspath
+			);
+		} catch (...) {
+			std::cerr << "ERROR: Cannot serve metrics:\n" <<
+			boost::current_exception_diagnostic_information() << std::endl;
+		}
+	}
+	// made by the startup steps; declared first so that they outlast any
+	// step still running when the steps are destroyed
+	std::unique_ptr<Umbra> umbra;
+	std::unique_ptr<Horizon> horizon;
+	std::unique_ptr<SunEphemeris> ephemeris;
+	duds::ui::graphics::BppImageArchiveSptr iconArc;
 	std::shared_ptr<duds::hardware::devices::displays::SimulatedBppDisplay> sd;
 	duds::hardware::display::BppGraphicDisplaySptr disp;
 	// display configuration
 	duds::hardware::interface::PinConfiguration pc;
 	std::shared_ptr<duds::hardware::interface::DigitalPort> port;
 	duds::hardware::interface::DigitalPin buzzer;
-	// ST7920
-	if (uselcd) {
-		boost::property_tree::ptree tree;
-		boost::property_tree::read_info(confpath, tree);
-		// if an exception is thrown here, the program will terminate without
-		// getting to the catch block below; don't know why
-		pc.parse(tree.get_child("pins"));
-		port = duds::hardware::interface::linux::GpioDevPort::makeConfiguredPort(pc);
-		duds::hardware::interface::DigitalPinSet lcdset;
-		duds::hardware::interface::ChipSelect lcdsel;
-		pc.getPinSetAndSelect(lcdset, lcdsel, lcdname);
-		std::shared_ptr<duds::hardware::devices::displays::ST7920> lcd =
-			std::make_shared<duds::hardware::devices::displays::ST7920>(
-				std::move(lcdset), std::move(lcdsel), dispW, dispH
-			);
-		lcd->initialize();
-		disp = lcd;
-		// also config other hardware using GPIO
-		pc.getPin(buzzer, "buzzer");
-	} else {
-		disp = sd = std::make_shared<duds::hardware::devices::displays::SimulatedBppDisplay>(
-			dispW, dispH
-		);
-		//disp = sd;
-	}
-	Clock = duds::hardware::devices::clocks::LinuxClock::make();
-	duds::time::planetary::Earth::make(zonepath);
-
-	// battery monitor
-	std::unique_ptr<duds::hardware::devices::instruments::INA219> batmon;
-	try {
-		std::unique_ptr<duds::hardware::interface::Smbus> smbus(
-			new duds::hardware::interface::linux::DevSmbus(
-				i2cpath,
-				0x40,
-				duds::hardware::interface::Smbus::NoPec()
-			)
+	// independent parts of bringing up the program run concurrently; the
+	// user interface starts once what it needs is ready
+	Startup startup;
+	// GDAL's registration is not thread safe, and both the umbra and horizon
+	// steps open datasets
+	GDALAllRegister();
+	// only the chosen dataset is opened
+	startup.add("umbra", { }, [&]() {
+		umbra = std::make_unique<Umbra>(shapepath, tlon < 200.0, layer);
+		umbra->prefilter(elements);
+	});
+	// optional terrain data
+	startup.add("horizon", { }, [&]() {
+		if (!dempath.empty()) {
+			horizon = std::make_unique<Horizon>(dempath);
+		}
+	});
+	startup.add("zone", { }, [&]() {
+		duds::time::planetary::Earth::make(zonepath);
+	});
+	// sun position fits for the day of the eclipse and the days around it
+	startup.add("ephemeris", { "zone" }, [&]() {
+		ephemeris = std::make_unique<SunEphemeris>(
+			eclipseDate - boost::gregorian::days(1), 3
 		);
-		batmon = std::make_unique<duds::hardware::devices::instruments::INA219>(
-			smbus, 0.1
+	});
+	startup.add("fonts", { }, [&]() {
+		FontPool.addWithCache("Date-small", extimgpath + "/font_Vx8.bppia");
+		FontPool.addWithCache("Date-medium", extimgpath + "/font_Vx8B.bppia");
+		//FontPool.addWithCache("Date-large", extimgpath + "/font_10x18.bppia");
+		//FontPool.addWithCache("Time-small", extimgpath + "/font_Vx7.bppia");
+		//FontPool.alias("Date-small", "Time-medium");
+		FontPool.alias("Date-small", "Time-tiny");
+		FontPool.alias("Date-medium", "Time-small");
+		FontPool.addWithCache("Time-medium", extimgpath + "/font_7x14.bppia");
+		FontPool.addWithCache("Time-large", imgpath + "/timefont_12x17.bppia");
+		FontPool.alias("Date-small", "Title");
+		//FontPool.alias("Date-medium", "Title");
+		FontPool.alias("Date-medium", "Text");
+		// load icons
+		iconArc = duds::ui::graphics::BppImageArchive::make(
+			imgpath + "/icons.bppia"
 		);
-	} catch (duds::hardware::interface::SmbusErrorNoBus &) {
-		std::cerr << "ERROR: " << i2cpath << " cannot be opened." << std::endl;
-	} catch (duds::hardware::interface::SmbusErrorNoDevice &) {
-		std::cerr << "ERROR: The INA219 is not found." << std::endl;
-	} catch (duds::hardware::interface::SmbusError &) {
-		std::cerr << "ERROR: An error prevented using the INA219:\n" <<
-		boost::current_exception_diagnostic_information() << std::endl;
-	}
-	// intialize exponential moving average for battery
-	if (batmon) {
-		batmon->sample();
-		displaystuff.initBatteryData(batmon->busVoltage(), batmon->busPower());
-	}
-	// temperature monitor
-	std::unique_ptr<duds::hardware::devices::instruments::AM2320> tempmon;
-	// the AM2320 can be tempermental
-	for (int t = 8; t > 0; --t) {
-		try {
-			std::unique_ptr<duds::hardware::interface::I2c> i2c(
-				new duds::hardware::interface::linux::DevI2c(i2cpath, 0x5C)
-			);
-			tempmon = std::make_unique<duds::hardware::devices::instruments::AM2320>(
-				i2c
+	});
+	startup.add("display", { }, [&]() {
+		// ST7920
+		if (uselcd) {
+			boost::property_tree::ptree tree;
+			boost::property_tree::read_info(confpath, tree);
+			// if an exception is thrown here, the program will terminate without
+			// getting to the catch block below; don't know why
+			pc.parse(tree.get_child("pins"));
+			port = duds::hardware::interface::linux::GpioDevPort::makeConfiguredPort(pc);
+			duds::hardware::interface::DigitalPinSet lcdset;
+			duds::hardware::interface::ChipSelect lcdsel;
+			pc.getPinSetAndSelect(lcdset, lcdsel, lcdname);
+			std::shared_ptr<duds::hardware::devices::displays::ST7920> lcd =
+				std::make_shared<duds::hardware::devices::displays::ST7920>(
+					std::move(lcdset), std::move(lcdsel), dispW, dispH
+				);
+			lcd->initialize();
+			disp = lcd;
+			// also config other hardware using GPIO
+			pc.getPin(buzzer, "buzzer");
+		} else {
+			disp = sd = std::make_shared<duds::hardware::devices::displays::SimulatedBppDisplay>(
+				dispW, dispH
 			);
-			break;
-		} catch (duds::hardware::interface::I2cErrorNoBus &) {
-			if (t == 1) {
-				std::cerr << "ERROR: " << i2cpath << " cannot be opened."
-				<< std::endl;
-			} else {
-				std::this_thread::sleep_for(std::chrono::seconds(1));
-			}
-		} catch (duds::hardware::interface::I2cErrorNoDevice &) {
-			if (t == 1) {
-				std::cerr << "ERROR: The AM2320 is not found." << std::endl;
-			} else {
-				std::this_thread::sleep_for(std::chrono::seconds(1));
-			}
-		} catch (duds::hardware::interface::I2cError &) {
-			if (t == 1) {
-				std::cerr << "ERROR: An error prevented using the AM2320:\n" <<
-				boost::current_exception_diagnostic_information() << std::endl;
+			//disp = sd;
+		}
+	});
+	// use test location?
+	if ((tlon < 200.0) || (tlat < 200.0)) {
+		// configure test data
+		displaystuff.setTesting();
+		curr = Location(tlon, tlat);
+		displaystuff.setCurrLoc(curr, 16, 8);
+		displaystuff.setCheckLoc(curr);
+		// compute total eclipse length once the data is loaded
+		startup.add("test check", { "umbra", "horizon", "zone" }, [&, curr]() {
+			check(*umbra, horizon.get(), scheduler, curr);
+			DisplayInfo di;
+			displaystuff.getInfo(di);
+			if (di.inTotality) {
+				std::cout << "In";
 			} else {
-				std::this_thread::sleep_for(std::chrono::seconds(1));
+				std::cout << "Out";
 			}
-		}
-	}
-	// intialize exponential moving average for temperature & humidity
-	if (tempmon) {
-		// the AM2320 can be tempermental
-		for (int t = 8; t > 0; --t) {
-			try {
-				std::this_thread::sleep_for(std::chrono::seconds(1));
-				tempmon->sample();
-				displaystuff.initTempData(
-					tempmon->temperature(),
-					tempmon->relHumidity()
-				);
-				break;
-			} catch (...) { }
-		}
+			std::cout << "side area of totality." << std::endl;
+		});
 	}
-	// brightness sensor
-	std::unique_ptr<duds::hardware::devices::instruments::TSL2591> brightmon;
-	double brightness = 0;
+	// watch NTP's discipline of the clock
+	std::unique_ptr<ClockMonitor> clockmon;
 	try {
-		std::unique_ptr<duds::hardware::interface::I2c> i2c(
-			new duds::hardware::interface::linux::DevI2c(i2cpath, 0x29)
-		);
-		brightmon = std::make_unique<duds::hardware::devices::instruments::TSL2591>(
-			i2c
-		);
-		brightmon->init(0, 0);
-		std::this_thread::sleep_for(std::chrono::milliseconds(128));
-		brightness = (double)brightmon->brightnessCount();
-	} catch (duds::hardware::interface::I2cErrorNoBus &) {
-		std::cerr << "ERROR: " << i2cpath << " cannot be opened." << std::endl;
-	} catch (duds::hardware::interface::I2cErrorNoDevice &) {
-		std::cerr << "ERROR: The TSL2591 is not found." << std::endl;
-	} catch (duds::hardware::interface::I2cError &) {
-		std::cerr << "ERROR: An error prevented using the TSL2591:\n" <<
-		boost::current_exception_diagnostic_information() << std::endl;
+		clockmon = std::make_unique<ClockMonitor>(clocklogpath);
+	} catch (ClockMonitorLogError &) {
+		std::cerr << "ERROR: Cannot create the clock log " << clocklogpath <<
+		std::endl;
+		clockmon = std::make_unique<ClockMonitor>();
 	}
+	const char *clockError = "Clock error";
+	bool clockGood = true;
+	// independent measure of the clock's error
+	std::unique_ptr<PpsInput> pps;
+	if (!ppspath.empty()) {
+		try {
+			pps = std::make_unique<PpsInput>(ppspath);
+		} catch (...) {
+			std::cerr << "ERROR: The PPS input cannot be used:\n" <<
+			boost::current_exception_diagnostic_information() << std::endl;
+		}
+	}
+
 	// PWM output - LCD brighness control
 	std::unique_ptr<duds::hardware::interface::linux::SysPwm> pwmout;
 	try {
@@ -397,187 +489,256 @@ try {
 		pwmout->disable();
 	} catch (...) {
 		std::cerr << "ERROR: No PWM output." << std::endl;
-		// no need for brightness
-		brightmon.reset();
 	}
+	// I2C sensors are opened and sampled on their own thread so they cannot
+	// hold up anything else; they show up once they respond
+	SensorWorker sensors;
+	sensors.add(std::make_unique<Ina219Sensor>(i2cpath, displaystuff));
+	sensors.add(std::make_unique<Am2320Sensor>(i2cpath, displaystuff));
+	// brightness is only needed to control the backlight
+	if (pwmout) {
+		sensors.add(std::make_unique<Tsl2591Sensor>(i2cpath, *pwmout));
+	}
+	sensors.start();
 	// make user interface
-	RunUi ui(std::move(disp), std::move(iconArc), Clock, displaystuff, buzzer);
+	startup.wait("display");
+	startup.wait("fonts");
+	startup.wait("ephemeris");
+	// the terrain can take a while to load; it is given to the user
+	// interface by the status task once ready
+	RunUi ui(
+		poller,
+		std::move(disp),
+		std::move(iconArc),
+		Clock,
+		displaystuff,
+		buzzer,
+		elements,
+		*ephemeris,
+		pps.get()
+	);
 	if (!ui.initInput() && !displaystuff.isTesting()) {
 		std::cerr << "ERROR: Failed to initialize input" << std::endl;
 		displaystuff.setError("Missing input", 16);
 	}
-	// start user interface thread
-	std::thread displayThread(&RunUi::run, std::ref(ui));
+	// show the first frame; the rest are timed by the poller
+	ui.start();
+	std::cout << "First frame shown at " << startup.elapsed() << 's' <<
+	std::endl;
 
 	// claim that the last totality check was 1 minute ago
 	auto lastCheck = std::chrono::system_clock::now() - std::chrono::minutes(1);
-	auto sampleTime = lastCheck;
 	std::future<void> eclipseCalc;
+	// true once the horizon step is done; used by the checks after that
+	bool horizonReady = false;
 	double speed = 0;  // in m/s
-	gps_data_t *gpsInfo;
+	PositionFilter gpsFilter;
 
-	// until signal requests termination
-	while (!quit) {
-		if (!displaystuff.isTesting()) {
-			if (gps) {
-				// up to 5 second delay
-				if (!gps->waiting(5000000)) {
-					continue;
-				}
-				gpsInfo = gps->read();
+	// handles each position report as it arrives
+	auto gpsReport = [&](const GpsFix &fix) {
+		metrics.gpsReports.inc();
+		auto now = std::chrono::system_clock::now();
+		auto diff = now - lastCheck;
+		double fixTime = std::isfinite(fix.time) ? fix.time : fix.arrival;
+		double err;
+		// without a position, dead reckon from the last filtered velocity so
+		// that the totality times stay current through short outages
+		bool estimated = !fix.hasLocation();
+		if (estimated) {
+			if (
+				!displaystuff.wasGood() ||
+				!gpsFilter.extrapolate(fixTime, curr, err)
+			) {
+				displaystuff.badFix();
+				return;
 			}
-			// failed?
-			if (!gps || !gpsInfo) {
-				speed = 0;
-				// attempt to re-establish contact with gpsd
-				gps.reset();
-				do {
-					displaystuff.setError("No gpsd connection", 8);
-					gps = std::unique_ptr<gpsmm>(
-						new gpsmm("localhost", DEFAULT_GPSD_PORT)
-					);
-					if (!gps->stream(WATCH_ENABLE|WATCH_JSON)) {
-						gps.reset();
-						std::this_thread::sleep_for(std::chrono::seconds(2));
-					}
-				} while (!gps && !quit);
-				displaystuff.clearError();
-			} else if (gps) {
-				// gps_data_t::status moved to gps_fix_t
-				if (                                  // with no satellite signals,
-					(gpsInfo->fix.status == 0) ||     // the first two conditionals
-					(gpsInfo->fix.mode != MODE_3D) || // usually are false, so 3D
-					(gpsInfo->satellites_used == 0)   // fix with no satillites is
-				) {                                   // possible?
-					displaystuff.badFix();
-				}
-				// keep exponential moving average of speed for deciding when to
-				// recalculate times of totality
-				if (gpsInfo->set & SPEED_SET) {
-					speed = 0.8 * speed + 0.2 * gpsInfo->fix.speed;
-				}
-				if (gpsInfo->set & LATLON_SET) {
-					auto now = std::chrono::system_clock::now();
-					auto diff = now - lastCheck;
-					if (displaystuff.wasGood()) {
-						curr.lon = curr.lon * (1.0 - 0.5 / gpsInfo->fix.epx) +
-							0.5 / gpsInfo->fix.epx * gpsInfo->fix.longitude;
-						curr.lat = curr.lat * (1.0 - 0.5 / gpsInfo->fix.epy) +
-							0.5 / gpsInfo->fix.epy * gpsInfo->fix.latitude;
-					}
-					// protect against the position values going bad (NaN)
-					if (!displaystuff.wasGood() || !std::isnormal(curr.lon) ||
-						!std::isnormal(curr.lat)
-					) {
-						curr.lon = gpsInfo->fix.longitude;
-						curr.lat = gpsInfo->fix.latitude;
-					}
-					displaystuff.setCurrLoc(
-						curr ,
-						(int)std::max(gpsInfo->fix.epy, gpsInfo->fix.epx),
-						gpsInfo->satellites_used
-					);
-					/** @todo  Do not check for totality after totality. */
-					// take into account a position offset (curr with off)
-					Location cwo = curr + displaystuff.getLocOffset();
-					double dist = haversineEarth(prev, cwo);
-					// do not recompute too often, unless a large change in
-					// position occurred
-					if ((diff > std::chrono::seconds(128)) || (dist > 1024.0)) {
-						// if the distance has changed by more than 64m and the
-						// speed is low . . .
-						if ((speed < 2.5) && (dist > 64.0)) {
-							lastCheck = now;
-							prev = cwo;
-							displaystuff.setCheckLoc(curr);
-							// start computing total eclipse length
-							eclipseCalc = std::async(
-								std::launch::async,
-								&check,
-								std::ref(umbra),
-								std::ref(cwo)
-							);
-							// *
-							std::cout << "Starting check " <<
-							std::chrono::duration_cast<std::chrono::seconds>(diff).count()
-							<< "s after last, dist = " << dist << std::endl;
-							// */
-						}
-					}
-				}
-			} else {
+		} else {
+			if (!fix.good()) {
 				displaystuff.badFix();
 			}
+			// start over after the fix was lost
+			if (!displaystuff.wasGood()) {
+				gpsFilter.reset();
+			}
+			gpsFilter.update(fixTime, fix.loc, fix.epx, fix.epy);
+			gpsFilter.velocity(fix.speed, fix.track, fix.eps);
+			// the filtered speed decides when to recalculate times of totality
+			speed = gpsFilter.speed();
+			curr = gpsFilter.position();
+			// protect against the position values going bad (NaN)
+			if (!std::isfinite(curr.lon) || !std::isfinite(curr.lat)) {
+				gpsFilter.reset();
+				curr = fix.loc;
+			}
+			err = gpsFilter.uncertainty();
+		}
+		displaystuff.setCurrLoc(curr, (int)err, fix.satellites, estimated);
+		/** @todo  Do not check for totality after totality. */
+		// take into account a position offset (curr with off)
+		Location cwo = curr + displaystuff.getLocOffset();
+		// recheck once the contact times are expected to have changed by more
+		// than half a second, but not often while moving quickly since the
+		// result would soon be stale
+		if (
+			((speed < 2.5) || (diff > std::chrono::seconds(15))) &&
+			// replacing a running check's future would block until it ends;
+			// the next report will try again
+			(!eclipseCalc.valid() || (
+				eclipseCalc.wait_for(std::chrono::seconds(0)) ==
+				std::future_status::ready
+			)) &&
+			scheduler.due(cwo) && startup.ready("umbra")
+		) {
+			double dist = scheduler.distance(cwo);
+			double change = scheduler.expectedChange(cwo);
+			lastCheck = now;
+			scheduler.started(cwo);
+			displaystuff.setCheckLoc(curr, estimated);
+			// start computing total eclipse length
+			eclipseCalc = std::async(
+				std::launch::async,
+				&check,
+				std::ref(*umbra),
+				horizonReady ? horizon.get() : nullptr,
+				std::ref(scheduler),
+				cwo
+			);
+			// *
+			std::cout << "Starting check " <<
+			std::chrono::duration_cast<std::chrono::seconds>(diff).count()
+			<< "s after last, dist = " << dist << ", expected change = "
+			<< change << "s" << std::endl;
+			// */
+		}
+	};
+	// GPS reports are handled while waiting on the poller
+	std::unique_ptr<GpsSource> gpsd;
+	std::unique_ptr<GpsRecorder> recorder;
+	GpsReplay *replay = nullptr;
+	const char *gpsdError = "No gpsd connection";
+	bool gpsdUp = true;
+	if (!displaystuff.isTesting()) {
+		GpsFixHandler handler = gpsReport;
+		if (!recordpath.empty()) {
+			recorder = std::make_unique<GpsRecorder>(recordpath);
+			handler = [&recorder, &gpsReport](const GpsFix &fix) {
+				recorder->record(fix);
+				gpsReport(fix);
+			};
+		}
+		if (!replaypath.empty()) {
+			std::unique_ptr<GpsReplay> rp = std::make_unique<GpsReplay>(
+				poller,
+				handler,
+				replaypath,
+				replaySpeed
+			);
+			replay = rp.get();
+			gpsd = std::move(rp);
+		} else if (serialpath.empty()) {
+			gpsd = std::make_unique<GpsClient>(poller, handler);
 		} else {
-			// testing, so sleep while waiting to quit
-			std::this_thread::sleep_for(std::chrono::seconds(2));
+			gpsd = std::make_unique<SerialGps>(
+				poller,
+				handler,
+				serialpath,
+				baud
+			);
+			gpsdError = "No GPS data";
 		}
-		// sample sensors
-		auto now = std::chrono::system_clock::now();
-		if ((now - sampleTime) >= std::chrono::seconds(2)) {
-			sampleTime = now;
-			if (batmon) {
-				try {
-					batmon->sample();
-					displaystuff.setBatteryData(
-						batmon->busVoltage(),
-						batmon->busPower()
-					);
-				} catch (...) { }
-			}
-			if (tempmon) {
-				try {
-					tempmon->sample();
-					displaystuff.setTempData(
-						tempmon->temperature(),
-						tempmon->relHumidity()
-					);
-				} catch (...) { }
+	}
+
+	// periodic work
+	TaskWheel tasks(poller);
+	// check on startup, the GPS and the clock each second
+	tasks.add("status", std::chrono::seconds(1), std::chrono::milliseconds(100),
+	[&]() {
+		// failures in starting up are fatal, as they were before the steps
+		// ran concurrently
+		startup.check();
+		if (!horizonReady && startup.ready("horizon")) {
+			horizonReady = true;
+			if (horizon) {
+				ui.setHorizon(horizon.get());
+				// make the terrain profile for the location
+				scheduler.force();
 			}
 		}
-		// brighness is always sampled
-		if (brightmon) {
-			try {
-				brightmon->sample();
-			} catch (...) {
-				try {
-					std::this_thread::sleep_for(std::chrono::milliseconds(10));
-					brightmon->init(0, 0);
-				} catch (...) {
-					brightmon.reset();
-					pwmout->dutyCycle(0.4);
-					pwmout->enable();
-				}
+		if (gpsd) {
+			if (replay && replay->finished()) {
+				std::cout << "Replayed " << replay->played() << " GPS reports"
+				<< std::endl;
+				quit = true;
+			} else if (!gpsd->connected()) {
+				speed = 0;
+				gpsFilter.reset();
+				displaystuff.setError(gpsdError, 8);
+				gpsdUp = false;
+			} else if (!gpsdUp) {
+				displaystuff.clearError(gpsdError);
+				gpsdUp = true;
 			}
-			// may have been destroyed above
-			if (brightmon) {
-				brightness = brightness * 0.8 +
-					0.2 * (double)brightmon->brightnessCount();
-				// plenty bright?
-				if (brightness > 11000.0) {
-					// no need of backlight
-					pwmout->disable();
-				}
-				// somewhat bright
-				else if (brightness > 8777.0) {
-					// max backlight
-					pwmout->dutyFull();
-					pwmout->enable();
-				}
-				// dim
-				else {
-					// minimum backlight out of 10% at 1000 (not really) and below.
-					/**
-					 * @bug  If an exception is thrown in the next line, the
-					 *       process will abort even though this is inside
-					 *       a try-catch block that should catch any exception
-					 *       type.
-					 */
-					pwmout->dutyCycle(std::max((brightness - 1000.0) / (7000.0 / 0.9), 0.08));
-					pwmout->enable();
-				}
+		}
+		double ppsError = NAN;
+		if (pps) {
+			PpsTiming timing = pps->status();
+			ppsError = timing.error();
+			displaystuff.setPpsTiming(
+				timing.locked ? timing.offset : NAN,
+				ppsError
+			);
+		}
+		// the timer already keeps the interval
+		if (clockmon->sample()) {
+			const ClockSample &cs = clockmon->latest();
+			displaystuff.setClockState(
+				cs.offset,
+				cs.error,
+				clockmon->worstError(3600),
+				cs.synced
+			);
+			// a PPS lock corrects the time used for the alarms, so the
+			// clock's own error only matters without it; NaN is ignored
+			double error = std::min(cs.error, ppsError);
+			// an error of 0.1s or more is noticeable in the alarms
+			if ((error > 0.1) && displaystuff.contactAhead()) {
+				displaystuff.setError(clockError, 8);
+				clockGood = false;
+			} else if (!clockGood) {
+				displaystuff.clearError(clockError);
+				clockGood = true;
 			}
 		}
+	});
+
+	// until signal requests termination; the timers and devices registered
+	// with the poller do all the work, so this only wakes when something
+	// needs doing
+	while (!quit) {
+		if (poller.wait(std::chrono::seconds(60)) == poller.maxEvents) {
+			for (int limit = 8; limit && (poller.respond() == poller.maxEvents); --limit) { }
+		}
+	}
+	sensors.stop();
+	// report any trouble keeping to the task periods
+	auto reportTask = [](const TaskStats &ts) {
+		if (ts.misses) {
+			std::cout << ts.name << " task missed " << ts.misses <<
+			" deadlines in " << ts.runs << " runs, worst " <<
+			ts.worstLate * 1000.0 << "ms late" << std::endl;
+		}
+	};
+	for (int t = 0; t < tasks.size(); ++t) {
+		reportTask(tasks.stats(t));
+	}
+	for (int t = 0; t < sensors.size(); ++t) {
+		reportTask(sensors.stats(t));
+		SensorHealth sh = sensors.device(t).health();
+		if (sh.errors) {
+			std::cout << sensors.device(t).name() << " had " << sh.errors <<
+			" errors in " << sh.samples << " samples and was opened " <<
+			sh.opens << " times" << std::endl;
+		}
 	}
 	// wait for threads to end
 	try {
@@ -585,18 +746,6 @@ try {
 	} catch (...) {
 		// may not have run the thread; ignore
 	}
-	try {
-		// doesn't seem thread-safe, but next line hangs process without it
-		if (displayThread.joinable()) {
-			displayThread.join();
-		}
-	} catch (const std::system_error& e) {
-		// invalid_argument may occur if thread has terminated
-		if (e.code() != std::errc::invalid_argument) {
-			// something else
-			throw;
-		}
-	}
 	//std::cout << std::endl;
 	return 0;
 } catch (...) {
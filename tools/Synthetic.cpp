@@ -0,0 +1,64 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#include "Synthetic.hpp"
+#include <cmath>
+
+/**
+ * Approximate meters per degree of latitude.
+ */
+static constexpr double metersPerDegree = 111195.0;
+
+Location offset(const Location &l, double east, double north) {
+	return Location(
+		l.lon + east / (metersPerDegree * std::cos(l.lat * M_PI / 180.0)),
+		l.lat + north / metersPerDegree
+	);
+}
+
+void pathDirection(
+	const Besselian &bes,
+	const Location &loc,
+	double &alongE,
+	double &alongN
+) {
+	LocalCircumstances lc;
+	bes.local(lc, loc);
+	ShadowPosition sp0, sp1;
+	bes.shadow(sp0, lc.max - 30.0);
+	bes.shadow(sp1, lc.max + 30.0);
+	alongE = (sp1.center.lon - sp0.center.lon) *
+		std::cos(loc.lat * M_PI / 180.0);
+	alongN = sp1.center.lat - sp0.center.lat;
+	double len = std::sqrt(alongE * alongE + alongN * alongN);
+	alongE /= len;
+	alongN /= len;
+}
+
+Location findEdge(
+	const Besselian &bes,
+	const Location &loc,
+	double dirE,
+	double dirN
+) {
+	LocalCircumstances lc;
+	double in = 0, out = 200000.0;
+	while ((out - in) > 1.0) {
+		double mid = (in + out) / 2.0;
+		bes.local(lc, offset(loc, dirE * mid, dirN * mid));
+		if (lc.total) {
+			in = mid;
+		} else {
+			out = mid;
+		}
+	}
+	return offset(loc, dirE * in, dirN * in);
+}
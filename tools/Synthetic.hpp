@@ -0,0 +1,51 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+#ifndef SYNTHETIC_HPP
+#define SYNTHETIC_HPP
+
+#include "Besselian.hpp"
+
+/**
+ * @file
+ * Helpers for making synthetic locations near the path of totality for the
+ * benchmark and test programs.
+ */
+
+/**
+ * Moves a location by the given distances in meters. Only good for short
+ * distances, which is all that is needed here.
+ */
+Location offset(const Location &l, double east, double north);
+
+/**
+ * Finds the direction of the path of totality near a location as a unit
+ * vector, in meters east and north, along the path.
+ */
+void pathDirection(
+	const Besselian &bes,
+	const Location &loc,
+	double &alongE,
+	double &alongN
+);
+
+/**
+ * Finds a point on the predicted edge of the path by searching from the given
+ * location, which must be inside the path, in the given direction.
+ */
+Location findEdge(
+	const Besselian &bes,
+	const Location &loc,
+	double dirE,
+	double dirN
+);
+
+#endif        //  #ifndef SYNTHETIC_HPP
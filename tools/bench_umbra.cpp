@@ -0,0 +1,213 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+/**
+ * @file
+ * A benchmark for Umbra::check(). It replays synthetic GPS tracks against the
+ * umbra shapes and reports the latency of each check along with the work done.
+ * Only the shapefile is needed; no display, GPS, or other hardware is used.
+ * @author  Jeff Jackowski
+ */
+
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cmath>
+#include "Synthetic.hpp"
+#include "Umbra.hpp"
+
+/**
+ * A named sequence of locations, one per GPS fix.
+ */
+struct Track {
+	const char *name;
+	std::vector<Location> points;
+	Track(const char *n) : name(n) { }
+};
+
+static void runTrack(Umbra &umbra, const Track &track) {
+	std::vector<double> lat;
+	lat.reserve(track.points.size());
+	int inside = 0;
+	umbra.resetStats();
+	for (const Location &l : track.points) {
+		auto start = std::chrono::steady_clock::now();
+		if (umbra.check(l.lon, l.lat)) {
+			++inside;
+		}
+		auto end = std::chrono::steady_clock::now();
+		lat.push_back(
+			std::chrono::duration<double, std::micro>(end - start).count()
+		);
+	}
+	std::sort(lat.begin(), lat.end());
+	auto pct = [&lat](double p) {
+		return lat[std::min((std::size_t)(p * lat.size()), lat.size() - 1)];
+	};
+	const UmbraStats &stats = umbra.stats();
+	double n = (double)track.points.size();
+	std::cout << std::left << std::setw(12) << track.name << std::right <<
+	std::fixed << std::setprecision(1) <<
+	std::setw(7) << track.points.size() <<
+	std::setw(7) << inside <<
+	std::setw(10) << pct(0.5) <<
+	std::setw(10) << pct(0.9) <<
+	std::setw(10) << pct(0.99) <<
+	std::setw(10) << lat.back() <<
+	std::setw(10) << (double)stats.features / n <<
+	std::setw(10) << (double)stats.polygonTests / n <<
+	std::setw(8) << stats.rejected << std::endl;
+}
+
+int main(int argc, char *argv[])
+try {
+	std::string shapepath, layer;
+	Location center;
+	int count;
+	unsigned int seed;
+	bool noprefilter = false;
+	{ // option parsing
+		boost::program_options::options_description optdesc(
+			"Options for the Umbra benchmark"
+		);
+		optdesc.add_options()
+			( // help info
+				"help,h",
+				"Show this help message"
+			)
+			(
+				"shape",
+				boost::program_options::value<std::string>(&shapepath)->
+					default_value("../umbra_hi.shp"),
+				"Path to shapefile"
+			)
+			(
+				"layer",
+				boost::program_options::value<std::string>(&layer)->
+					default_value("umbra_hi"),
+				"Name of the layer with the umbra shapes"
+			)
+			(
+				"lon",
+				boost::program_options::value<double>(&center.lon)->
+					default_value(-93.2586701),
+				"Longitude inside the path to center the tracks on"
+			)
+			(
+				"lat",
+				boost::program_options::value<double>(&center.lat)->
+					default_value(35.2170883),
+				"Latitude inside the path to center the tracks on"
+			)
+			(
+				"count,n",
+				boost::program_options::value<int>(&count)->
+					default_value(1000),
+				"Number of GPS fixes in each track"
+			)
+			(
+				"seed",
+				boost::program_options::value<unsigned int>(&seed)->
+					default_value(2024),
+				"Random number seed"
+			)
+			(
+				"noprefilter",
+				"Do not use the Besselian element prefilter"
+			)
+		;
+		boost::program_options::variables_map vm;
+		boost::program_options::store(
+			boost::program_options::parse_command_line(argc, argv, optdesc),
+			vm
+		);
+		boost::program_options::notify(vm);
+		if (vm.count("help")) {
+			std::cout << "Umbra benchmark.\n\t" << argv[0] << " [options]\n"
+			<< optdesc << std::endl;
+			return 0;
+		}
+		if (vm.count("noprefilter")) {
+			noprefilter = true;
+		}
+	}
+	GDALAllRegister();
+	Umbra umbra(shapepath, false, layer);
+	if (!noprefilter) {
+		umbra.prefilter(&Eclipse20240408);
+	}
+	Besselian bes;
+	double alongE, alongN;
+	pathDirection(bes, center, alongE, alongN);
+	std::mt19937 gen(seed);
+	std::vector<Track> tracks;
+	{ // GPS noise while not moving
+		std::normal_distribution<double> jitter(0.0, 5.0);
+		Track &t = tracks.emplace_back("stationary");
+		for (int i = 0; i < count; ++i) {
+			t.points.push_back(offset(center, jitter(gen), jitter(gen)));
+		}
+	}
+	{ // cross the path on a 160km line starting 80km outside of it; the fixes
+	  // are spread evenly over the line, so 160m apart with 1000 fixes
+		std::normal_distribution<double> jitter(0.0, 3.0);
+		Track &t = tracks.emplace_back("highway");
+		double step = 160000.0 / (double)count;
+		for (int i = 0; i < count; ++i) {
+			double d = -80000.0 + step * (double)i;
+			t.points.push_back(offset(
+				center,
+				-alongN * d + jitter(gen),
+				alongE * d + jitter(gen)
+			));
+		}
+	}
+	{ // walk along the edge of the path, wandering in and out
+		std::normal_distribution<double> jitter(0.0, 3.0);
+		Location edge = findEdge(bes, center, -alongN, alongE);
+		Track &t = tracks.emplace_back("edge walk");
+		for (int i = 0; i < count; ++i) {
+			// 1.4m/s with a 50m sway across the edge
+			double along = 1.4 * (double)i;
+			double across = 50.0 * std::sin((double)i / 60.0);
+			t.points.push_back(offset(
+				edge,
+				alongE * along - alongN * across + jitter(gen),
+				alongN * along + alongE * across + jitter(gen)
+			));
+		}
+	}
+	std::cout << "Prefilter " << (noprefilter ? "disabled" : "enabled") <<
+	"; latency in microseconds, work per check\n" <<
+	std::left << std::setw(12) << "track" << std::right <<
+	std::setw(7) << "checks" <<
+	std::setw(7) << "in" <<
+	std::setw(10) << "p50" <<
+	std::setw(10) << "p90" <<
+	std::setw(10) << "p99" <<
+	std::setw(10) << "max" <<
+	std::setw(10) << "features" <<
+	std::setw(10) << "polygons" <<
+	std::setw(8) << "reject" << std::endl;
+	for (const Track &t : tracks) {
+		runTrack(umbra, t);
+	}
+	return 0;
+} catch (...) {
+	std::cerr << "Program failed in main():\n" <<
+	boost::current_exception_diagnostic_information() << std::endl;
+	return 1;
+}
@@ -0,0 +1,269 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+/**
+ * @file
+ * Reports the accuracy and speed of SunEphemeris compared with sunTerms() and
+ * sunPosition() across all of the cached days, and checks the elevation
+ * crossings it finds against a scan of sunPosition().
+ * @author  Jeff Jackowski
+ */
+
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/program_options.hpp>
+#include <duds/time/planetary/Planetary.hpp>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <cmath>
+#include "SunEphemeris.hpp"
+
+/**
+ * A place to check along with the largest differences found there.
+ */
+struct Place {
+	const char *name;
+	Location loc;
+	double elErr = 0;
+	double azErr = 0;
+	Place(const char *n, const Location &l) : name(n), loc(l) { }
+};
+
+/**
+ * Finds the first time within a span that the sun crosses an elevation by
+ * stepping through the span with sunPosition(), then bisecting to the second.
+ * @return  True if a crossing was found.
+ */
+static bool scanCrossing(
+	duds::time::interstellar::SecondTime &when,
+	bool &rising,
+	const Location &loc,
+	double elev,
+	const duds::time::interstellar::SecondTime &from,
+	const duds::time::interstellar::SecondTime &to,
+	int step
+) {
+	double az, el0, el1;
+	sunPosition(az, el0, loc, from);
+	for (
+		duds::time::interstellar::SecondTime t = from;
+		t < to;
+		t += duds::time::interstellar::Seconds(step)
+	) {
+		duds::time::interstellar::SecondTime t1 =
+			std::min(t + duds::time::interstellar::Seconds(step), to);
+		sunPosition(az, el1, loc, t1);
+		if ((el0 < elev) != (el1 < elev)) {
+			rising = el1 > el0;
+			duds::time::interstellar::SecondTime a = t, b = t1;
+			while ((b - a).count() > 1) {
+				duds::time::interstellar::SecondTime mid =
+					a + duds::time::interstellar::Seconds((b - a).count() / 2);
+				double el;
+				sunPosition(az, el, loc, mid);
+				if ((el < elev) == (el0 < elev)) {
+					a = mid;
+				} else {
+					b = mid;
+				}
+			}
+			when = b;
+			return true;
+		}
+		el0 = el1;
+	}
+	return false;
+}
+
+int main(int argc, char *argv[])
+try {
+	std::string datestr, zonepath;
+	int count, step;
+	{ // option parsing
+		boost::program_options::options_description optdesc(
+			"Options for the sun ephemeris accuracy report"
+		);
+		optdesc.add_options()
+			( // help info
+				"help,h",
+				"Show this help message"
+			)
+			(
+				"zone,z",
+				boost::program_options::value<std::string>(&zonepath)->
+					default_value("/usr/share/zoneinfo-leaps/UTC"),
+				"Path to zoneinfo file with leap seconds"
+			)
+			(
+				"date",
+				boost::program_options::value<std::string>(&datestr)->
+					default_value("2024-04-07"),
+				"First day to cache"
+			)
+			(
+				"days",
+				boost::program_options::value<int>(&count)->
+					default_value(3),
+				"Number of days to cache"
+			)
+			(
+				"step",
+				boost::program_options::value<int>(&step)->
+					default_value(60),
+				"Seconds between comparisons"
+			)
+		;
+		boost::program_options::variables_map vm;
+		boost::program_options::store(
+			boost::program_options::parse_command_line(argc, argv, optdesc),
+			vm
+		);
+		boost::program_options::notify(vm);
+		if (vm.count("help")) {
+			std::cout << "Sun ephemeris accuracy report.\n\t" << argv[0] <<
+			" [options]\n" << optdesc << std::endl;
+			return 0;
+		}
+	}
+	boost::gregorian::date first = boost::gregorian::from_simple_string(datestr);
+	// needed for all of the time conversions
+	duds::time::planetary::Earth::make(zonepath);
+	auto start = std::chrono::steady_clock::now();
+	SunEphemeris eph(first, count);
+	auto end = std::chrono::steady_clock::now();
+	std::cout << "Fit " << count << " days in " <<
+	std::chrono::duration<double, std::micro>(end - start).count() <<
+	" microseconds" << std::endl;
+	std::vector<Place> places = {
+		Place("Mazatlan", Location(-106.4111, 23.2494)),
+		Place("Dallas", Location(-96.7970, 32.7767)),
+		Place("Mt Nebo", Location(-93.2586701, 35.2170883)),
+		Place("Houlton", Location(-67.8403, 46.1259)),
+		Place("Anchorage", Location(-149.9003, 61.2181)),
+		Place("Quito", Location(-78.4678, -0.1807))
+	};
+	duds::time::interstellar::SecondTime t0, t1;
+	duds::time::planetary::earth->date(t0, first);
+	duds::time::planetary::earth->date(
+		t1,
+		first + boost::gregorian::days(count)
+	);
+	// differences in the slow terms
+	double declErr = 0, eqtErr = 0;
+	std::vector<duds::time::interstellar::SecondTime> times;
+	for (
+		duds::time::interstellar::SecondTime t = t0;
+		t < t1;
+		t += duds::time::interstellar::Seconds(step)
+	) {
+		times.push_back(t);
+		SunTerms ref, fit;
+		sunTerms(ref, t);
+		eph.terms(fit, t);
+		declErr = std::max(declErr, std::fabs(ref.decl - fit.decl));
+		eqtErr = std::max(eqtErr, std::fabs(ref.eqtime - fit.eqtime));
+		for (Place &p : places) {
+			double raz, rel, faz, fel;
+			sunPosition(raz, rel, p.loc, t);
+			eph.position(faz, fel, p.loc, t);
+			p.elErr = std::max(p.elErr, std::fabs(rel - fel));
+			// azimuth is poorly defined with the sun near the zenith
+			if (rel < 89.0) {
+				p.azErr = std::max(
+					p.azErr,
+					std::fabs(std::remainder(raz - faz, 360.0))
+				);
+			}
+		}
+	}
+	std::cout << "Compared " << times.size() << " times\n" <<
+	"Maximum declination error: " << std::setprecision(3) <<
+	declErr * 180.0 / M_PI * 3600.0 << " arcseconds\n" <<
+	"Maximum equation of time error: " <<
+	eqtErr * 60.0 << " seconds\n" <<
+	"Maximum position error in degrees:\n" << std::left << std::setw(12) <<
+	"place" << std::right << std::setw(12) << "elevation" << std::setw(12) <<
+	"azimuth" << std::endl;
+	for (const Place &p : places) {
+		std::cout << std::left << std::setw(12) << p.name << std::right <<
+		std::setw(12) << p.elErr << std::setw(12) << p.azErr << std::endl;
+	}
+	// speed
+	double az, el, sum = 0;
+	start = std::chrono::steady_clock::now();
+	for (const duds::time::interstellar::SecondTime &t : times) {
+		sunPosition(az, el, places[2].loc, t);
+		sum += el;
+	}
+	end = std::chrono::steady_clock::now();
+	double slow = std::chrono::duration<double, std::nano>(end - start).count() /
+		(double)times.size();
+	start = std::chrono::steady_clock::now();
+	for (const duds::time::interstellar::SecondTime &t : times) {
+		eph.position(az, el, places[2].loc, t);
+		sum -= el;
+	}
+	end = std::chrono::steady_clock::now();
+	double fast = std::chrono::duration<double, std::nano>(end - start).count() /
+		(double)times.size();
+	std::cout << "Nanoseconds per position: sunPosition() " << std::fixed <<
+	std::setprecision(0) << slow << ", SunEphemeris " << fast <<
+	"\n(ignore: " << std::setprecision(3) << sum << ')' << std::endl;
+	// elevation crossings on each day; the sun reaches 80 degrees only near
+	// the tropics, so most places also check a day without a crossing
+	const double elevs[] = { -0.833, 30.0, 80.0 };
+	int agree = 0, none = 0, wrong = 0;
+	long crossErr = 0;
+	for (const Place &p : places) {
+		for (double elev : elevs) {
+			for (int d = 0; d < count; ++d) {
+				duds::time::interstellar::SecondTime from =
+					t0 + duds::time::interstellar::Seconds(d * 60 * 60 * 24);
+				duds::time::interstellar::SecondTime to =
+					from + duds::time::interstellar::Seconds(60 * 60 * 24);
+				duds::time::interstellar::SecondTime ref, fit;
+				bool refRise, fitRise;
+				bool refFound = scanCrossing(
+					ref, refRise, p.loc, elev, from, to, step
+				);
+				bool fitFound = eph.crossing(
+					fit, fitRise, p.loc, elev, from, to
+				);
+				if (!refFound && !fitFound) {
+					++none;
+				} else if (
+					(refFound != fitFound) || (refRise != fitRise) ||
+					(std::labs((ref - fit).count()) > 2)
+				) {
+					++wrong;
+					std::cout << "Crossing mismatch at " << p.name << " for " <<
+					std::setprecision(3) << elev << " degrees on day " << d <<
+					": scan " << (refFound ? (ref - from).count() : -1L) <<
+					"s, ephemeris " << (fitFound ? (fit - from).count() : -1L) <<
+					's' << std::endl;
+				} else {
+					++agree;
+					crossErr = std::max(crossErr, std::labs((ref - fit).count()));
+				}
+			}
+		}
+	}
+	std::cout << "Elevation crossings: " << agree << " agree within " <<
+	crossErr << "s, " << none << " days without a crossing, " << wrong <<
+	" mismatched" << std::endl;
+	return wrong ? 1 : 0;
+} catch (...) {
+	std::cerr << "Program failed in main():\n" <<
+	boost::current_exception_diagnostic_information() << std::endl;
+	return 1;
+}
@@ -0,0 +1,324 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+/**
+ * @file
+ * Replays GPS fixes through PositionFilter. Given a file of recorded fixes,
+ * it reports how much the raw and filtered positions jump around and how
+ * many totality rechecks each would cause under the 64 meter rule used by
+ * the program. Without a file, it makes synthetic tracks with known true
+ * positions and fails if the filter is less accurate than the raw fixes, or
+ * if dead reckoning through a simulated outage misses the true position by
+ * more than its reported uncertainty.
+ *
+ * The fix file has one fix per line with whitespace separated values:
+ *   time lon lat epx epy [speed track eps]
+ * Time is in seconds, errors are 95% confidence values as reported by gpsd,
+ * and lines starting with '#' are ignored. A binary recording made with the
+ * program's --record option may be used instead.
+ * @author  Jeff Jackowski
+ */
+
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/program_options.hpp>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <vector>
+#include <cmath>
+#include "GpsRecord.hpp"
+#include "PositionFilter.hpp"
+
+struct Fix {
+	double time;
+	Location loc;
+	double epx, epy;
+	double speed = NAN, track = NAN, eps = NAN;
+	/**
+	 * The true location, if known.
+	 */
+	Location truth;
+};
+
+/**
+ * Counts the rechecks that would be done when a location moves more than
+ * 64m from the last checked location.
+ */
+struct RecheckCounter {
+	LocalFrame frame;
+	int count = 0;
+	bool first = true;
+	void add(const Location &l) {
+		if (first || (frame.distance(l) > 64.0)) {
+			frame.anchor(l);
+			++count;
+			first = false;
+		}
+	}
+};
+
+static std::vector<Fix> readFixes(const std::string &path) {
+	std::vector<Fix> fixes;
+	std::ifstream in(path);
+	if (!in) {
+		throw std::runtime_error("Cannot open " + path);
+	}
+	std::string line;
+	while (std::getline(in, line)) {
+		if (line.empty() || (line[0] == '#')) {
+			continue;
+		}
+		std::istringstream iss(line);
+		Fix f;
+		if (iss >> f.time >> f.loc.lon >> f.loc.lat >> f.epx >> f.epy) {
+			iss >> f.speed >> f.track >> f.eps;
+			fixes.push_back(f);
+		}
+	}
+	return fixes;
+}
+
+static std::vector<Fix> readRecording(const std::string &path) {
+	std::vector<Fix> fixes;
+	GpsRecordReader reader(path);
+	GpsFix gf;
+	while (reader.next(gf)) {
+		if (!gf.hasLocation()) {
+			continue;
+		}
+		Fix f;
+		f.time = std::isfinite(gf.time) ? gf.time : gf.arrival;
+		f.loc = gf.loc;
+		f.epx = gf.epx;
+		f.epy = gf.epy;
+		f.speed = gf.speed;
+		f.track = gf.track;
+		f.eps = gf.eps;
+		fixes.push_back(f);
+	}
+	return fixes;
+}
+
+/**
+ * Makes one fix per second following a track that starts at @a start and
+ * has the given velocity, with a turn partway through when @a turn is not
+ * zero.
+ */
+static std::vector<Fix> makeTrack(
+	std::mt19937 &gen,
+	const Location &start,
+	double speed,
+	double turn,
+	int count,
+	double err
+) {
+	std::vector<Fix> fixes;
+	LocalFrame frame(start);
+	std::normal_distribution<double> noise(0.0, err / 1.96);
+	std::normal_distribution<double> speedNoise(0.0, 0.2);
+	double heading = 0.3, e = 0, n = 0;
+	for (int i = 0; i < count; ++i) {
+		if ((i > count / 2) && (i < (count / 2 + 20))) {
+			heading += turn / 20.0;
+		}
+		e += speed * std::sin(heading);
+		n += speed * std::cos(heading);
+		Fix f;
+		f.time = (double)i;
+		f.truth = frame.toLocation(Enu(e, n));
+		f.loc = frame.toLocation(Enu(e + noise(gen), n + noise(gen)));
+		f.epx = f.epy = err;
+		if (speed > 0) {
+			f.speed = speed + speedNoise(gen);
+			f.track = heading * 180.0 / M_PI;
+			f.eps = 0.4;
+		}
+		fixes.push_back(f);
+	}
+	return fixes;
+}
+
+/**
+ * Runs the fixes through the filter.
+ * @return  False if the filter did worse than the raw fixes when the truth
+ *          is known.
+ */
+static bool replay(const char *name, const std::vector<Fix> &fixes, bool truth) {
+	PositionFilter filter;
+	RecheckCounter rawChecks, filtChecks;
+	double rawJump = 0, filtJump = 0, rawErr = 0, filtErr = 0;
+	Location prevRaw, prevFilt;
+	for (std::size_t i = 0; i < fixes.size(); ++i) {
+		const Fix &f = fixes[i];
+		filter.update(f.time, f.loc, f.epx, f.epy);
+		filter.velocity(f.speed, f.track, f.eps);
+		Location fl = filter.position();
+		rawChecks.add(f.loc);
+		filtChecks.add(fl);
+		if (i) {
+			rawJump += vincentyEarth(prevRaw, f.loc);
+			filtJump += vincentyEarth(prevFilt, fl);
+		}
+		prevRaw = f.loc;
+		prevFilt = fl;
+		if (truth) {
+			double d = vincentyEarth(f.truth, f.loc);
+			rawErr += d * d;
+			d = vincentyEarth(f.truth, fl);
+			filtErr += d * d;
+		}
+	}
+	double n = (double)fixes.size();
+	std::cout << std::left << std::setw(12) << name << std::right <<
+	std::fixed << std::setprecision(2) <<
+	std::setw(7) << fixes.size() <<
+	std::setw(10) << rawJump / (n - 1.0) <<
+	std::setw(10) << filtJump / (n - 1.0) <<
+	std::setw(8) << rawChecks.count <<
+	std::setw(8) << filtChecks.count;
+	if (truth) {
+		std::cout << std::setw(10) << std::sqrt(rawErr / n) <<
+		std::setw(10) << std::sqrt(filtErr / n);
+	}
+	std::cout << std::endl;
+	return !truth || (filtErr < rawErr);
+}
+
+/**
+ * Runs the fixes through the filter up to @a from, then dead reckons the
+ * position at several times after that as though the fix was lost.
+ * @return  False if an estimate is farther from the truth than its
+ *          uncertainty.
+ */
+static bool coast(const char *name, const std::vector<Fix> &fixes, int from) {
+	PositionFilter filter;
+	for (int i = 0; i <= from; ++i) {
+		const Fix &f = fixes[i];
+		filter.update(f.time, f.loc, f.epx, f.epy);
+		filter.velocity(f.speed, f.track, f.eps);
+	}
+	bool good = true;
+	std::cout << std::left << std::setw(12) << name << std::right;
+	for (int ahead : { 5, 15, 30, 60 }) {
+		const Fix &f = fixes[from + ahead];
+		Location loc;
+		double err;
+		if (!filter.extrapolate(f.time, loc, err)) {
+			std::cout << std::setw(16) << "none";
+			continue;
+		}
+		double d = vincentyEarth(f.truth, loc);
+		good = good && (d <= err);
+		std::cout << std::setw(8) << d << std::setw(8) << err;
+	}
+	std::cout << std::endl;
+	return good;
+}
+
+int main(int argc, char *argv[])
+try {
+	std::string fixpath, recpath;
+	unsigned int seed;
+	{ // option parsing
+		boost::program_options::options_description optdesc(
+			"Options for the position filter replay"
+		);
+		optdesc.add_options()
+			( // help info
+				"help,h",
+				"Show this help message"
+			)
+			(
+				"fixes",
+				boost::program_options::value<std::string>(&fixpath),
+				"File of recorded fixes; synthetic tracks are used if omitted"
+			)
+			(
+				"record",
+				boost::program_options::value<std::string>(&recpath),
+				"Binary recording of GPS reports to use instead of --fixes"
+			)
+			(
+				"seed",
+				boost::program_options::value<unsigned int>(&seed)->
+					default_value(2024),
+				"Random number seed for synthetic tracks"
+			)
+		;
+		boost::program_options::variables_map vm;
+		boost::program_options::store(
+			boost::program_options::parse_command_line(argc, argv, optdesc),
+			vm
+		);
+		boost::program_options::notify(vm);
+		if (vm.count("help")) {
+			std::cout << "Position filter replay.\n\t" << argv[0] <<
+			" [options]\n" << optdesc << std::endl;
+			return 0;
+		}
+	}
+	std::cout << "Mean jump between fixes and RMS error in meters\n" <<
+	std::left << std::setw(12) << "track" << std::right <<
+	std::setw(7) << "fixes" <<
+	std::setw(10) << "raw jump" <<
+	std::setw(10) << "filt jump" <<
+	std::setw(8) << "raw rc" <<
+	std::setw(8) << "filt rc" <<
+	std::setw(10) << "raw err" <<
+	std::setw(10) << "filt err" << std::endl;
+	if (!fixpath.empty() || !recpath.empty()) {
+		std::vector<Fix> fixes;
+		if (!recpath.empty()) {
+			fixes = readRecording(recpath);
+		} else {
+			fixes = readFixes(fixpath);
+		}
+		if (fixes.size() < 2) {
+			std::cerr << "Too few fixes" << std::endl;
+			return 1;
+		}
+		replay("recorded", fixes, false);
+		return 0;
+	}
+	std::mt19937 gen(seed);
+	const Location start(-93.2586701, 35.2170883);
+	std::vector<Fix> stationary = makeTrack(gen, start, 0, 0, 1800, 8.0);
+	std::vector<Fix> walking = makeTrack(gen, start, 1.4, 1.5, 1800, 6.0);
+	std::vector<Fix> driving = makeTrack(gen, start, 25.0, 1.5, 600, 4.0);
+	bool good = replay("stationary", stationary, true);
+	good = replay("walking", walking, true) && good;
+	good = replay("driving", driving, true) && good;
+	if (!good) {
+		std::cout << "FAIL: filtered positions less accurate than raw fixes" <<
+		std::endl;
+		return 1;
+	}
+	// outages start on the straight part of the tracks, before the turn
+	std::cout << "\nDead reckoning error and uncertainty in meters after\n" <<
+	std::left << std::setw(12) << "track" << std::right <<
+	std::setw(16) << "5s" << std::setw(16) << "15s" <<
+	std::setw(16) << "30s" << std::setw(16) << "60s" << std::endl;
+	good = coast("stationary", stationary, 600);
+	good = coast("walking", walking, 600) && good;
+	good = coast("driving", driving, 200) && good;
+	if (!good) {
+		std::cout << "FAIL: dead reckoning outside of its uncertainty" <<
+		std::endl;
+		return 1;
+	}
+	return 0;
+} catch (...) {
+	std::cerr << "Program failed in main():\n" <<
+	boost::current_exception_diagnostic_information() << std::endl;
+	return 2;
+}
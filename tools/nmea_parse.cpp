@@ -0,0 +1,275 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+/**
+ * @file
+ * Runs recorded GPS receiver output, NMEA with optional UBX, through
+ * GpsParser. Prints each fix, the parser's counts, and the time taken per
+ * byte. The data is fed in pieces of a chosen size to exercise the handling
+ * of messages split across reads. Instead of a file, built-in output that
+ * mixes NMEA with UBX messages holding a '$' in their payload may be used;
+ * a parser that takes the '$' as the start of a sentence can miss the
+ * following NAV-PVT message. Exits with a non-zero value if no fixes were
+ * found, or if any of the built-in fixes were missed.
+ * @author  Jeff Jackowski
+ */
+
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <iterator>
+#include <vector>
+#include "GpsParser.hpp"
+
+/**
+ * Appends an NMEA sentence with its checksum.
+ * @param out   The data to append to.
+ * @param body  The sentence without the leading '$' and the checksum.
+ */
+static void appendNmea(std::vector<char> &out, const std::string &body) {
+	std::uint8_t sum = 0;
+	for (char c : body) {
+		sum ^= c;
+	}
+	char tail[8];
+	std::snprintf(tail, sizeof(tail), "*%02X\r\n", sum);
+	out.push_back('$');
+	out.insert(out.end(), body.begin(), body.end());
+	out.insert(out.end(), tail, tail + 5);
+}
+
+/**
+ * Appends a UBX message with its sync bytes and checksum.
+ * @param out      The data to append to.
+ * @param cls      The message class.
+ * @param id       The message ID.
+ * @param payload  The message payload.
+ */
+static void appendUbx(
+	std::vector<char> &out,
+	std::uint8_t cls,
+	std::uint8_t id,
+	const std::vector<std::uint8_t> &payload
+) {
+	std::vector<std::uint8_t> m = {
+		cls, id,
+		(std::uint8_t)payload.size(), (std::uint8_t)(payload.size() >> 8)
+	};
+	m.insert(m.end(), payload.begin(), payload.end());
+	std::uint8_t a = 0, b = 0;
+	for (std::uint8_t c : m) {
+		a += c;
+		b += a;
+	}
+	out.push_back((char)0xB5);
+	out.push_back(0x62);
+	out.insert(out.end(), m.begin(), m.end());
+	out.push_back((char)a);
+	out.push_back((char)b);
+}
+
+/**
+ * Writes a little-endian value into a UBX payload.
+ */
+static void put(std::uint8_t *p, std::int32_t val, int bytes) {
+	for (int i = 0; i < bytes; ++i) {
+		p[i] = (std::uint8_t)(val >> (i * 8));
+	}
+}
+
+/**
+ * Makes receiver output like that from a u-blox receiver with NAV-SAT
+ * enabled: each epoch has a NAV-SAT message too long for the parser to keep,
+ * with a '$' and printable bytes at the end of its payload, then a NAV-PVT
+ * message, then RMC and GGA sentences.
+ * @param epochs  The number of epochs to make; each should produce a fix.
+ */
+static std::vector<char> mixedOutput(int epochs) {
+	std::vector<char> out;
+	for (int e = 0; e < epochs; ++e) {
+		std::vector<std::uint8_t> sat(200);
+		put(&sat[0], 64800000 + e * 1000, 4);  // iTOW
+		sat[4] = 1;
+		sat[5] = 16;  // numSvs, but the records are left blank
+		sat[196] = '$';
+		sat[197] = 'G';
+		sat[198] = 'P';
+		sat[199] = 'S';
+		// Choose a reserved byte so the checksum is printable, too. The
+		// false sentence then runs up to the sync byte of the NAV-PVT.
+		for (int r = 0; r < 256; ++r) {
+			sat[6] = (std::uint8_t)r;
+			std::vector<char> m;
+			appendUbx(m, 0x01, 0x35, sat);
+			std::uint8_t a = m[m.size() - 2], b = m[m.size() - 1];
+			if ((a >= 0x20) && (a <= 0x7E) && (b >= 0x20) && (b <= 0x7E)) {
+				break;
+			}
+		}
+		appendUbx(out, 0x01, 0x35, sat);
+		std::vector<std::uint8_t> pvt(92);
+		put(&pvt[0], 64800000 + e * 1000, 4);  // iTOW
+		put(&pvt[4], 2024, 2);
+		pvt[6] = 4;
+		pvt[7] = 8;
+		pvt[8] = 18;
+		pvt[9] = 0;
+		pvt[10] = e;
+		pvt[11] = 7;   // valid date, time, and fully resolved
+		pvt[20] = 3;   // 3D fix
+		pvt[21] = 1;   // gnssFixOK
+		pvt[23] = 16;  // satellites
+		put(&pvt[24], -840000000 + e * 100, 4);  // lon
+		put(&pvt[28], 390000000, 4);             // lat
+		put(&pvt[32], 250000, 4);                // height
+		put(&pvt[40], 1500, 4);                  // hAcc
+		put(&pvt[60], 1000, 4);                  // gSpeed
+		put(&pvt[64], 9000000, 4);               // headMot
+		put(&pvt[68], 200, 4);                   // sAcc
+		appendUbx(out, 0x01, 0x07, pvt);
+		char time[16];
+		std::snprintf(time, sizeof(time), "1800%02d.00", e);
+		appendNmea(out, std::string("GPRMC,") + time +
+			",A,3900.0000,N,08400.0000,W,1.9,90.0,080424,,,A");
+		appendNmea(out, std::string("GPGGA,") + time +
+			",3900.0000,N,08400.0000,W,1,16,0.9,250.0,M,0.0,M,,");
+	}
+	return out;
+}
+
+int main(int argc, char *argv[])
+try {
+	std::string path;
+	std::size_t chunk;
+	int repeat;
+	bool quiet = false;
+	int mixed = 0;
+	{ // option parsing
+		boost::program_options::options_description optdesc(
+			"Options for the GPS parser test"
+		);
+		optdesc.add_options()
+			( // help info
+				"help,h",
+				"Show this help message"
+			)
+			(
+				"file",
+				boost::program_options::value<std::string>(&path),
+				"File of recorded receiver output"
+			)
+			(
+				"mixed",
+				boost::program_options::value<int>(&mixed),
+				"Parse this many epochs of built-in output mixing NMEA with "
+				"UBX messages that contain a '$' instead of a file"
+			)
+			(
+				"chunk",
+				boost::program_options::value<std::size_t>(&chunk)->
+					default_value(64),
+				"Bytes given to the parser at a time"
+			)
+			(
+				"repeat",
+				boost::program_options::value<int>(&repeat)->
+					default_value(1),
+				"Times to parse the file for timing"
+			)
+			(
+				"quiet,q",
+				"Do not print each fix"
+			)
+		;
+		boost::program_options::variables_map vm;
+		boost::program_options::store(
+			boost::program_options::parse_command_line(argc, argv, optdesc),
+			vm
+		);
+		if (vm.count("help")) {
+			std::cout << "GPS parser test.\n\t" << argv[0] <<
+			" [options]\n" << optdesc << std::endl;
+			return 0;
+		}
+		boost::program_options::notify(vm);
+		if (vm.count("quiet")) {
+			quiet = true;
+		}
+		if (path.empty() == !mixed) {
+			std::cerr << "Give either a file or a number of mixed epochs" <<
+			std::endl;
+			return 1;
+		}
+	}
+	std::vector<char> data;
+	if (mixed) {
+		data = mixedOutput(mixed);
+	} else {
+		std::ifstream in(path, std::ios::binary);
+		if (!in) {
+			std::cerr << "Cannot open " << path << std::endl;
+			return 1;
+		}
+		data.assign(
+			std::istreambuf_iterator<char>(in),
+			std::istreambuf_iterator<char>()
+		);
+	}
+	if (!chunk) {
+		chunk = 1;
+	}
+	std::cout << std::fixed;
+	GpsParser parser([&quiet](const GpsFix &fix) {
+		if (quiet) {
+			return;
+		}
+		std::cout << std::setprecision(2) << fix.time << ' ' <<
+		std::setprecision(7) << fix.loc.lon << ' ' << fix.loc.lat <<
+		std::setprecision(1) << "  err " << fix.epx << ' ' << fix.epy <<
+		std::setprecision(2) << "  spd " << fix.speed << " trk " << fix.track <<
+		"  mode " << fix.mode << " status " << fix.status << " sats " <<
+		fix.satellites << std::endl;
+	});
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeat; ++r) {
+		for (std::size_t pos = 0; pos < data.size(); pos += chunk) {
+			// pretend the data arrives over time
+			parser.feed(
+				data.data() + pos,
+				std::min(chunk, data.size() - pos),
+				(double)pos
+			);
+		}
+		quiet = true;
+	}
+	std::chrono::duration<double, std::nano> elapsed =
+		std::chrono::steady_clock::now() - start;
+	const GpsParserStats &st = parser.stats();
+	std::cout << "Sentences: " << st.sentences << "\nUBX messages: " << st.ubx <<
+	"\nBad: " << st.bad << "\nFixes: " << st.fixes << std::setprecision(1) <<
+	"\nTime per byte: " << elapsed.count() / ((double)data.size() * repeat) <<
+	"ns" << std::endl;
+	if (mixed) {
+		// each pass has one NAV-PVT per epoch, and the fixes come from them;
+		// missing one loses the fix to the NMEA sentences instead
+		unsigned long pvts = (unsigned long)mixed * repeat;
+		return ((st.ubx == pvts) && (st.fixes == pvts)) ? 0 : 1;
+	}
+	return st.fixes ? 0 : 1;
+} catch (...) {
+	std::cerr << "Program failed in main():\n" <<
+	boost::current_exception_diagnostic_information() << std::endl;
+	return 2;
+}
@@ -0,0 +1,282 @@
+/*
+ * This file is part of the Eclipse2024 project. It is subject to the GPLv3
+ * license terms in the LICENSE file found in the top-level directory of this
+ * distribution and at
+ * https://github.com/jjackowski/eclipse2024/blob/master/LICENSE.
+ * No part of the Eclipse2024 project, including this file, may be copied,
+ * modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE file.
+ *
+ * Copyright (C) 2024  Jeff Jackowski
+ */
+/**
+ * @file
+ * A differential test for Umbra::check(). Each configuration of Umbra is
+ * compared against an oracle that tests the location against every shape in
+ * the shapefile. Locations are chosen at random across North America, near the
+ * path of totality, and hugging the edge of the path, and are checked in a
+ * random order so that any state kept between checks is also tested. Any
+ * disagreement is reported with the offending location.
+ * @author  Jeff Jackowski
+ */
+
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/exception/errinfo_file_name.hpp>
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <cmath>
+#include "Synthetic.hpp"
+#include "Umbra.hpp"
+
+/**
+ * Finds the times of totality the slow way by testing the location against
+ * every shape in the layer with GEOS. There is no attempt to be clever, so
+ * there is little that can go wrong.
+ */
+class UmbraOracle : boost::noncopyable {
+	GDALDatasetUPtr dataset;
+	OGRLayer *umbras;
+public:
+	UmbraOracle(const std::string &fname, const std::string &layer) {
+		dataset = GDALDatasetUPtr((GDALDataset*)GDALOpenEx(
+			fname.c_str(), GDAL_OF_VECTOR, nullptr, nullptr, nullptr
+		), GDALDatasetDeleter());
+		if (!dataset) {
+			BOOST_THROW_EXCEPTION(UmbraOpenError() <<
+				boost::errinfo_file_name(fname)
+			);
+		}
+		umbras = dataset->GetLayerByName(layer.c_str());
+		if (!umbras) {
+			BOOST_THROW_EXCEPTION(UmbraNoLayer() <<
+				boost::errinfo_file_name(fname) << UmbraLayerName(layer)
+			);
+		}
+	}
+	/**
+	 * Returns true if any shape contains the location, and provides the
+	 * earliest and latest times of the shapes that contain it.
+	 */
+	bool check(double lon, double lat, int &start, int &end) {
+		OGRPoint loc(lon, lat);
+		bool found = false;
+		umbras->ResetReading();
+		OGRFeatureUPtr feature;
+		while ((feature = OGRFeatureUPtr(
+			umbras->GetNextFeature(), OGRFeatureDeleter()
+		))) {
+			OGRGeometry *shadow = feature->GetGeometryRef();
+			if (shadow && loc.Within(shadow)) {
+				int t = feature->GetFieldAsInteger(1);
+				if (!found) {
+					start = end = t;
+					found = true;
+				} else {
+					start = std::min(start, t);
+					end = std::max(end, t);
+				}
+			}
+		}
+		return found;
+	}
+};
+
+/**
+ * A configuration of Umbra to compare against the oracle.
+ */
+struct Subject {
+	const char *name;
+	std::unique_ptr<Umbra> umbra;
+	int disagree = 0;
+	Subject(const char *n, std::unique_ptr<Umbra> &&u) :
+		name(n), umbra(std::move(u)) { }
+};
+
+/**
+ * A location to test and how it was chosen.
+ */
+struct TestPoint {
+	Location loc;
+	const char *kind;
+	TestPoint(const Location &l, const char *k) : loc(l), kind(k) { }
+};
+
+int main(int argc, char *argv[])
+try {
+	std::string shapepath, layer;
+	int wide, near, edge;
+	unsigned int seed;
+	{ // option parsing
+		boost::program_options::options_description optdesc(
+			"Options for the Umbra differential test"
+		);
+		optdesc.add_options()
+			( // help info
+				"help,h",
+				"Show this help message"
+			)
+			(
+				"shape",
+				boost::program_options::value<std::string>(&shapepath)->
+					default_value("../umbra_hi.shp"),
+				"Path to shapefile"
+			)
+			(
+				"layer",
+				boost::program_options::value<std::string>(&layer)->
+					default_value("umbra_hi"),
+				"Name of the layer with the umbra shapes"
+			)
+			(
+				"wide",
+				boost::program_options::value<int>(&wide)->
+					default_value(100),
+				"Number of random locations across North America"
+			)
+			(
+				"near",
+				boost::program_options::value<int>(&near)->
+					default_value(200),
+				"Number of random locations near the path of totality"
+			)
+			(
+				"edge",
+				boost::program_options::value<int>(&edge)->
+					default_value(200),
+				"Number of random locations within 3km of the edge of the path"
+			)
+			(
+				"seed",
+				boost::program_options::value<unsigned int>(&seed)->
+					default_value(2024),
+				"Random number seed"
+			)
+		;
+		boost::program_options::variables_map vm;
+		boost::program_options::store(
+			boost::program_options::parse_command_line(argc, argv, optdesc),
+			vm
+		);
+		boost::program_options::notify(vm);
+		if (vm.count("help")) {
+			std::cout << "Umbra differential test.\n\t" << argv[0] <<
+			" [options]\n" << optdesc << std::endl;
+			return 0;
+		}
+	}
+	GDALAllRegister();
+	UmbraOracle oracle(shapepath, layer);
+	// the configurations of Umbra under test
+	std::vector<Subject> subjects;
+	subjects.emplace_back(
+		"prefilter",
+		std::make_unique<Umbra>(shapepath, false, layer)
+	);
+	subjects.back().umbra->prefilter(&Eclipse20240408);
+	subjects.emplace_back(
+		"shapes only",
+		std::make_unique<Umbra>(shapepath, false, layer)
+	);
+	// find the span of time the umbra is on the Earth
+	Besselian bes;
+	double tstart = 0, tend = 0;
+	for (double t = 12.0 * 3600.0; t < 24.0 * 3600.0; t += 60.0) {
+		ShadowPosition sp;
+		bes.shadow(sp, t);
+		if (sp.onEarth) {
+			if (tstart == 0) {
+				tstart = t;
+			}
+			tend = t;
+		}
+	}
+	// pick test locations
+	std::mt19937 gen(seed);
+	std::vector<TestPoint> points;
+	{
+		std::uniform_real_distribution<double> lon(-115.0, -60.0);
+		std::uniform_real_distribution<double> lat(15.0, 55.0);
+		for (int i = 0; i < wide; ++i) {
+			points.emplace_back(Location(lon(gen), lat(gen)), "wide");
+		}
+	}
+	std::uniform_real_distribution<double> when(tstart, tend);
+	std::uniform_real_distribution<double> unit(-1.0, 1.0);
+	for (int i = 0; i < (near + edge); ++i) {
+		ShadowPosition sp;
+		bes.shadow(sp, when(gen));
+		double alongE, alongN;
+		pathDirection(bes, sp.center, alongE, alongN);
+		if (i < near) {
+			// anywhere from the center to 30km beyond the edge
+			double across = unit(gen) * (sp.umbraRadius + 30.0) * 1000.0;
+			points.emplace_back(
+				offset(sp.center, -alongN * across, alongE * across),
+				"near"
+			);
+		} else {
+			// pick an edge, then move up to 3km to either side of it
+			double side = (unit(gen) < 0) ? -1.0 : 1.0;
+			Location el = findEdge(bes, sp.center, -alongN * side, alongE * side);
+			double across = unit(gen) * 3000.0;
+			points.emplace_back(
+				offset(el, -alongN * across, alongE * across),
+				"edge"
+			);
+		}
+	}
+	std::shuffle(points.begin(), points.end(), gen);
+	// run the tests
+	int inside = 0;
+	for (const TestPoint &tp : points) {
+		int ostart = 0, oend = 0;
+		bool oin = oracle.check(tp.loc.lon, tp.loc.lat, ostart, oend);
+		if (oin) {
+			++inside;
+		}
+		for (Subject &s : subjects) {
+			bool sin = s.umbra->check(tp.loc.lon, tp.loc.lat);
+			if (
+				(sin != oin) || (oin && (
+					(s.umbra->startTime() != ostart) ||
+					(s.umbra->endTime() != oend)
+				))
+			) {
+				++s.disagree;
+				std::cout << std::setprecision(8) << std::fixed <<
+				"MISMATCH " << s.name << " at " << tp.kind << " location " <<
+				tp.loc.lon << ", " << tp.loc.lat << "\n\toracle: ";
+				if (oin) {
+					std::cout << Hms(ostart).time() << " to " << Hms(oend).time();
+				} else {
+					std::cout << "outside";
+				}
+				std::cout << "\n\t" << s.name << ": ";
+				if (sin) {
+					std::cout << Hms(s.umbra->startTime()).time() << " to " <<
+					Hms(s.umbra->endTime()).time();
+				} else {
+					std::cout << "outside";
+				}
+				std::cout << std::endl;
+			}
+		}
+	}
+	int fails = 0;
+	std::cout << "Checked " << points.size() << " locations, " << inside <<
+	" inside the path" << std::endl;
+	for (const Subject &s : subjects) {
+		std::cout << std::setw(12) << s.name << ": " << s.disagree <<
+		" disagreements" << std::endl;
+		fails += s.disagree;
+	}
+	return fails ? 1 : 0;
+} catch (...) {
+	std::cerr << "Program failed in main():\n" <<
+	boost::current_exception_diagnostic_information() << std::endl;
+	return 2;
+}